@@ -0,0 +1,172 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include "futex.h"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+    #include <immintrin.h>
+    #define ADAPTIVE_MUTEX_X86
+#endif
+
+// Tells the CPU that this is a spin-wait loop. On x86, PAUSE throttles the
+// loop and frees the pipeline for a hyperthread sibling. It also avoids the
+// memory-order mis-speculation penalty when the lock word finally changes.
+inline void cpuRelax() {
+#if defined(ADAPTIVE_MUTEX_X86)
+    _mm_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    asm volatile("yield");
+#endif
+}
+
+struct AdaptiveMutexStats {
+    uint64_t acquisitions = 0;  // lock() and successful try_lock() calls
+    uint64_t contended = 0;     // lock() calls that found the lock taken
+    uint64_t parks = 0;         // futex waits, i.e. trips into the kernel
+};
+
+// Mutex for very short critical sections. lock() spins with exponential
+// backoff of pause instructions, then parks on a futex. The lock word has
+// three states: free, locked, or locked with threads possibly parked. Only
+// the last state makes unlock() call into the kernel.
+//
+// The spin budget adapts. Each acquisition won by spinning pulls a running
+// estimate toward the pauses it needed, which reflects how long the holder
+// keeps the lock. Each spin that gave up and parked pulls the estimate down,
+// so a lock held for long stops burning CPU. The budget is twice the
+// estimate, clamped to [MIN_SPINS, MAX_SPINS]. On a single CPU the holder
+// cannot run while we spin, so contended lock() calls park at once.
+//
+// Meets the standard Lockable requirements, so it drops in for std::mutex
+// under lock_guard, unique_lock, scoped_lock and condition_variable_any.
+class AdaptiveMutex {
+public:
+    static constexpr int MIN_SPINS = 16;     // pauses, even after spinning kept failing
+    static constexpr int MAX_SPINS = 4096;
+    static constexpr int MAX_BACKOFF = 64;   // pauses between two looks at the lock
+
+private:
+    static constexpr uint32_t UNLOCKED = 0;
+    static constexpr uint32_t LOCKED = 1;
+    static constexpr uint32_t CONTENDED = 2;  // locked, and a waiter may be parked
+
+    std::atomic<uint32_t> state_{UNLOCKED};
+    std::atomic<int> spinEstimate_{MIN_SPINS};  // updated without ordering, a hint only
+    // Written only by the thread holding the lock, so a load and a store
+    // suffice; they share the lock's cache line, which the holder owns anyway
+    std::atomic<uint64_t> acquisitions_{0};
+    std::atomic<uint64_t> contended_{0};
+    std::atomic<uint64_t> parks_{0};
+
+    static bool canSpin() {
+        static const bool multiCore = std::thread::hardware_concurrency() > 1;
+        return multiCore;
+    }
+
+    static void bump(std::atomic<uint64_t>& counter, uint64_t amount) {
+        counter.store(counter.load(std::memory_order_relaxed) + amount,
+                      std::memory_order_relaxed);
+    }
+
+    // Called with the lock held
+    void recordAcquisition(bool contended, uint64_t parks) {
+        bump(acquisitions_, 1);
+        if (contended) {
+            bump(contended_, 1);
+            bump(parks_, parks);
+        }
+    }
+
+    bool tryAcquire() {
+        uint32_t expected = UNLOCKED;
+        return state_.compare_exchange_strong(expected, LOCKED, std::memory_order_acquire,
+                                              std::memory_order_relaxed);
+    }
+
+    // Spins until the lock is won or the budget is spent; adjusts the estimate
+    bool spin() {
+        int estimate = spinEstimate_.load(std::memory_order_relaxed);
+        int budget = std::min(MAX_SPINS, std::max(MIN_SPINS, 2 * estimate));
+        int spent = 0;
+        int backoff = 1;
+        while (spent < budget) {
+            for (int i = 0; i < backoff; ++i) {
+                cpuRelax();
+            }
+            spent += backoff;
+            backoff = std::min(2 * backoff, MAX_BACKOFF);
+            // Read before the CAS so waiters do not steal the line from the holder
+            if (state_.load(std::memory_order_relaxed) == UNLOCKED && tryAcquire()) {
+                spinEstimate_.store(estimate + (spent - estimate) / 8, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        spinEstimate_.store(estimate - estimate / 8, std::memory_order_relaxed);
+        return false;
+    }
+
+    void lockContended() {
+        uint64_t parks = 0;
+        if (!canSpin() || !spin()) {
+            // Mark the lock contended before sleeping so unlock() wakes us;
+            // winning it here keeps that mark, costing at most one spare wake
+            while (state_.exchange(CONTENDED, std::memory_order_acquire) != UNLOCKED) {
+                ++parks;
+                futexWait(&state_, CONTENDED, false);
+            }
+        }
+        recordAcquisition(true, parks);
+    }
+
+public:
+    AdaptiveMutex() = default;
+    AdaptiveMutex(const AdaptiveMutex&) = delete;
+    AdaptiveMutex& operator=(const AdaptiveMutex&) = delete;
+
+    void lock() {
+        if (tryAcquire()) {
+            recordAcquisition(false, 0);
+            return;
+        }
+        lockContended();
+    }
+
+    bool try_lock() {
+        if (!tryAcquire()) {
+            return false;
+        }
+        recordAcquisition(false, 0);
+        return true;
+    }
+
+    void unlock() {
+        if (state_.exchange(UNLOCKED, std::memory_order_release) == CONTENDED) {
+            futexWake(&state_, 1, false);
+        }
+    }
+
+    // Exact once every thread has stopped using the lock
+    AdaptiveMutexStats stats() const {
+        AdaptiveMutexStats stats;
+        stats.acquisitions = acquisitions_.load(std::memory_order_relaxed);
+        stats.contended = contended_.load(std::memory_order_relaxed);
+        stats.parks = parks_.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    // Only while no thread uses the lock
+    void resetStats() {
+        acquisitions_.store(0, std::memory_order_relaxed);
+        contended_.store(0, std::memory_order_relaxed);
+        parks_.store(0, std::memory_order_relaxed);
+        spinEstimate_.store(MIN_SPINS, std::memory_order_relaxed);
+    }
+
+    // Pauses a spin is currently expected to need; the budget is twice this
+    int spinEstimate() const {
+        return spinEstimate_.load(std::memory_order_relaxed);
+    }
+};
@@ -0,0 +1,403 @@
+#pragma once
+
+#include <algorithm>
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#ifndef _WIN32
+    #include <unistd.h>
+    #include <sys/mman.h>
+    #include <sys/types.h>
+#endif
+#ifdef __linux__
+    #include <dirent.h>
+    #include <pthread.h>
+    #include <sched.h>
+    #include <sys/syscall.h>
+#endif
+
+// Where threads and forked children run, and where their shared state lives.
+// The topology (CPUs this process may use, their core, package and NUMA
+// node) is read once from sysfs. A ThreadPlacement turns a worker index into
+// a CPU under one of these policies:
+//   compact  fill one core (all its hyperthreads), then the next core, then
+//            the next package and node: neighbours share caches
+//   scatter  one CPU per physical core, alternating between NUMA nodes,
+//            before any second hyperthread: spreads memory bandwidth and heat
+//   node[:N] only the CPUs of node N (default: the node we start on), spread
+//            over its cores; shared state is allocated on that node too
+// Pinning uses pthread_setaffinity_np for threads and sched_setaffinity for
+// processes. Outside Linux every pin is a no-op that returns false.
+
+struct CpuInfo {
+    int cpu = 0;
+    int core = 0;
+    int package = 0;
+    int node = 0;
+    int siblingRank = 0;  // 0 for the first hyperthread of a core, 1 for the second...
+};
+
+class CpuTopology {
+private:
+    std::vector<CpuInfo> cpus_;
+    int nodeCount_ = 1;
+
+#ifdef __linux__
+    static int readNumber(const std::string& path, int fallback) {
+        std::ifstream file(path);
+        int value = fallback;
+        if (!(file >> value)) {
+            return fallback;
+        }
+        return value;
+    }
+
+    // The nodeN entry inside /sys/devices/system/cpu/cpuK names its node
+    static int nodeOf(int cpu) {
+        std::string path = "/sys/devices/system/cpu/cpu" + std::to_string(cpu);
+        DIR* directory = opendir(path.c_str());
+        if (directory == nullptr) {
+            return 0;
+        }
+        int node = 0;
+        while (dirent* entry = readdir(directory)) {
+            std::string name = entry->d_name;
+            if (name.size() > 4 && name.compare(0, 4, "node") == 0 &&
+                std::all_of(name.begin() + 4, name.end(),
+                            [](char c) { return std::isdigit(static_cast<unsigned char>(c)) != 0; })) {
+                node = std::stoi(name.substr(4));
+                break;
+            }
+        }
+        closedir(directory);
+        return node;
+    }
+#endif
+
+    CpuTopology() {
+#ifdef __linux__
+        cpu_set_t allowed;
+        CPU_ZERO(&allowed);
+        if (sched_getaffinity(0, sizeof(allowed), &allowed) == 0) {
+            for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+                if (!CPU_ISSET(cpu, &allowed)) {
+                    continue;
+                }
+                std::string topology = "/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/topology/";
+                CpuInfo info;
+                info.cpu = cpu;
+                info.core = readNumber(topology + "core_id", cpu);
+                info.package = readNumber(topology + "physical_package_id", 0);
+                info.node = nodeOf(cpu);
+                cpus_.push_back(info);
+            }
+        }
+#endif
+        if (cpus_.empty()) {
+            unsigned count = std::max(1u, std::thread::hardware_concurrency());
+            for (unsigned cpu = 0; cpu < count; ++cpu) {
+                CpuInfo info;
+                info.cpu = static_cast<int>(cpu);
+                info.core = static_cast<int>(cpu);
+                cpus_.push_back(info);
+            }
+        }
+
+        // Rank hyperthreads within their core by CPU number
+        for (CpuInfo& info : cpus_) {
+            for (const CpuInfo& other : cpus_) {
+                if (other.package == info.package && other.core == info.core && other.cpu < info.cpu) {
+                    ++info.siblingRank;
+                }
+            }
+            nodeCount_ = std::max(nodeCount_, info.node + 1);
+        }
+    }
+
+public:
+    static const CpuTopology& get() {
+        static CpuTopology topology;
+        return topology;
+    }
+
+    // CPUs this process is allowed to run on
+    const std::vector<CpuInfo>& cpus() const {
+        return cpus_;
+    }
+
+    int nodeCount() const {
+        return nodeCount_;
+    }
+
+    // NUMA node of the CPU the caller is running on right now
+    int currentNode() const {
+#ifdef __linux__
+        int cpu = sched_getcpu();
+        for (const CpuInfo& info : cpus_) {
+            if (info.cpu == cpu) {
+                return info.node;
+            }
+        }
+#endif
+        return 0;
+    }
+};
+
+class ThreadPlacement {
+public:
+    enum class Policy { None, Compact, Scatter, Node };
+
+private:
+    Policy policy_ = Policy::None;
+    int node_ = -1;
+    std::vector<int> order_;  // CPUs in the order workers are placed on them
+
+    void buildOrder() {
+        const CpuTopology& topology = CpuTopology::get();
+        std::vector<CpuInfo> cpus = topology.cpus();
+        auto byCore = [](const CpuInfo& a, const CpuInfo& b) {
+            if (a.siblingRank != b.siblingRank) return a.siblingRank < b.siblingRank;
+            if (a.package != b.package) return a.package < b.package;
+            if (a.core != b.core) return a.core < b.core;
+            return a.cpu < b.cpu;
+        };
+
+        if (policy_ == Policy::Compact) {
+            std::sort(cpus.begin(), cpus.end(), [](const CpuInfo& a, const CpuInfo& b) {
+                if (a.node != b.node) return a.node < b.node;
+                if (a.package != b.package) return a.package < b.package;
+                if (a.core != b.core) return a.core < b.core;
+                return a.cpu < b.cpu;
+            });
+            for (const CpuInfo& info : cpus) {
+                order_.push_back(info.cpu);
+            }
+        } else if (policy_ == Policy::Scatter) {
+            // One list per node, cores before hyperthreads, then deal them out
+            std::vector<std::vector<int>> perNode(topology.nodeCount());
+            std::sort(cpus.begin(), cpus.end(), byCore);
+            for (const CpuInfo& info : cpus) {
+                perNode[info.node].push_back(info.cpu);
+            }
+            for (size_t round = 0; order_.size() < cpus.size(); ++round) {
+                for (const auto& list : perNode) {
+                    if (round < list.size()) {
+                        order_.push_back(list[round]);
+                    }
+                }
+            }
+        } else if (policy_ == Policy::Node) {
+            std::sort(cpus.begin(), cpus.end(), byCore);
+            for (const CpuInfo& info : cpus) {
+                if (info.node == node_) {
+                    order_.push_back(info.cpu);
+                }
+            }
+            if (order_.empty()) {
+                throw std::invalid_argument("No usable CPUs on node " + std::to_string(node_));
+            }
+        }
+    }
+
+#ifdef __linux__
+    bool fillSet(size_t index, cpu_set_t& set) const {
+        if (order_.empty()) {
+            return false;
+        }
+        CPU_ZERO(&set);
+        CPU_SET(order_[index % order_.size()], &set);
+        return true;
+    }
+#endif
+
+public:
+    ThreadPlacement() = default;
+
+    // Parses none, compact, scatter, node or node:N
+    static ThreadPlacement parse(const std::string& text) {
+        ThreadPlacement placement;
+        if (text == "none") {
+            return placement;
+        } else if (text == "compact") {
+            placement.policy_ = Policy::Compact;
+        } else if (text == "scatter") {
+            placement.policy_ = Policy::Scatter;
+        } else if (text == "node") {
+            placement.policy_ = Policy::Node;
+            placement.node_ = CpuTopology::get().currentNode();
+        } else if (text.compare(0, 5, "node:") == 0) {
+            placement.policy_ = Policy::Node;
+            placement.node_ = std::stoi(text.substr(5));
+        } else {
+            throw std::invalid_argument("Unknown placement: " + text);
+        }
+        placement.buildOrder();
+        return placement;
+    }
+
+    bool enabled() const {
+        return policy_ != Policy::None;
+    }
+
+    // CPU for the worker with this index (wrapping around), -1 if unpinned
+    int cpuFor(size_t index) const {
+        return order_.empty() ? -1 : order_[index % order_.size()];
+    }
+
+    // Node shared state should live on, -1 to leave it to the kernel: scatter
+    // spreads threads across nodes, so no single node is right for it
+    int memoryNode() const {
+        if (policy_ == Policy::Node) {
+            return node_;
+        }
+        if (policy_ == Policy::Compact) {
+            for (const CpuInfo& info : CpuTopology::get().cpus()) {
+                if (info.cpu == order_.front()) {
+                    return info.node;
+                }
+            }
+        }
+        return -1;
+    }
+
+    // Pins the calling thread; in a freshly forked child that is the process
+    bool pinCurrentThread(size_t index) const {
+#ifdef __linux__
+        cpu_set_t set;
+        return fillSet(index, set) && pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+        (void)index;
+        return false;
+#endif
+    }
+
+    bool pinThread(std::thread& thread, size_t index) const {
+#ifdef __linux__
+        cpu_set_t set;
+        return fillSet(index, set) &&
+               pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set) == 0;
+#else
+        (void)thread;
+        (void)index;
+        return false;
+#endif
+    }
+
+#ifdef __linux__
+    bool pinProcess(pid_t pid, size_t index) const {
+        cpu_set_t set;
+        return fillSet(index, set) && sched_setaffinity(pid, sizeof(set), &set) == 0;
+    }
+#endif
+
+    // none, compact, scatter or node:N
+    std::string name() const {
+        switch (policy_) {
+            case Policy::None: return "none";
+            case Policy::Compact: return "compact";
+            case Policy::Scatter: return "scatter";
+            case Policy::Node: return "node:" + std::to_string(node_);
+        }
+        return "none";
+    }
+
+    // e.g. "compact (cpus 0,1,2,3; 1 node)" for the first count workers
+    std::string describe(size_t count) const {
+        if (!enabled()) {
+            return "none";
+        }
+        std::string text = name() + " (cpus ";
+        for (size_t i = 0; i < std::min(count, order_.size()); ++i) {
+            text += (i == 0 ? "" : ",") + std::to_string(order_[i]);
+        }
+        if (count > order_.size()) {
+            text += ",...";
+        }
+        text += "; " + std::to_string(CpuTopology::get().nodeCount()) + " node" +
+                (CpuTopology::get().nodeCount() == 1 ? "" : "s") + ")";
+        return text;
+    }
+};
+
+// Maps anonymous memory whose pages the kernel should take from node (a
+// preference, so allocation still succeeds when the node is full). node < 0
+// or a single-node machine leaves placement to first touch. shared = true
+// maps MAP_SHARED so the memory survives fork() as shared state.
+inline void* allocateOnNode(size_t bytes, int node, bool shared = false) {
+#ifndef _WIN32
+    void* memory = mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                        (shared ? MAP_SHARED : MAP_PRIVATE) | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) {
+        throw std::bad_alloc();
+    }
+#ifdef __linux__
+    if (node >= 0 && node < 64 && CpuTopology::get().nodeCount() > 1) {
+        constexpr int MPOL_PREFERRED_MODE = 1;
+        unsigned long mask = 1ul << node;
+        // Best effort: without NUMA support in the kernel this fails harmlessly
+        syscall(SYS_mbind, memory, bytes, MPOL_PREFERRED_MODE, &mask, sizeof(mask) * 8 + 1, 0);
+    }
+#else
+    (void)node;
+#endif
+    return memory;
+#else
+    (void)node;
+    (void)shared;
+    return ::operator new(bytes);
+#endif
+}
+
+inline void releaseNodeMemory(void* memory, size_t bytes) {
+#ifndef _WIN32
+    munmap(memory, bytes);
+#else
+    (void)bytes;
+    ::operator delete(memory);
+#endif
+}
+
+// Allocator for containers whose elements should live on one NUMA node
+template <typename T>
+class NodeAllocator {
+public:
+    using value_type = T;
+    using propagate_on_container_move_assignment = std::true_type;
+
+    int node = -1;
+
+    NodeAllocator() = default;
+    explicit NodeAllocator(int memoryNode) : node(memoryNode) {}
+    template <typename U>
+    NodeAllocator(const NodeAllocator<U>& other) : node(other.node) {}
+
+    T* allocate(size_t count) {
+        if (count > std::numeric_limits<size_t>::max() / sizeof(T)) {
+            throw std::bad_alloc();
+        }
+        return static_cast<T*>(allocateOnNode(count * sizeof(T), node));
+    }
+
+    void deallocate(T* memory, size_t count) {
+        releaseNodeMemory(memory, count * sizeof(T));
+    }
+
+    template <typename U>
+    bool operator==(const NodeAllocator<U>& other) const {
+        return node == other.node;
+    }
+
+    template <typename U>
+    bool operator!=(const NodeAllocator<U>& other) const {
+        return node != other.node;
+    }
+};
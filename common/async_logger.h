@@ -0,0 +1,484 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#ifdef _WIN32
+    #include <io.h>
+#else
+    #include <unistd.h>
+#endif
+
+// Asynchronous line logger. Each producing thread owns a single-producer ring
+// of fixed-size records, so logging never takes a lock. When a ring is full
+// the producer yields until the flusher has made room; with setDropWhenFull()
+// the line is dropped and counted instead, which keeps benchmarks from being
+// paced by the output. A background flusher drains every ring into a large
+// buffer and emits it with one write() call.
+//
+// Text records are formatted by the producer. Binary records only capture the
+// format pointer and raw arguments and are formatted later by the flusher,
+// which keeps formatting cost off the logging threads. Formats use "{}" as the
+// placeholder and must be string literals (binary records keep the pointer).
+// String arguments of binary records keep at most STRING_BYTES characters;
+// longer ones are cut and end in "...".
+class AsyncLogger {
+public:
+    static constexpr size_t RING_CAPACITY = 256;
+    static constexpr size_t TEXT_BYTES = 112;
+    static constexpr size_t MAX_ARGUMENTS = 4;
+    static constexpr size_t STRING_BYTES = 16;
+    static constexpr size_t WRITE_BUFFER_BYTES = 64 * 1024;
+    static constexpr auto FLUSH_INTERVAL = std::chrono::milliseconds(1);
+
+    struct Stats {
+        uint64_t lines = 0;
+        uint64_t dropped = 0;
+        uint64_t queueDepth = 0;
+        uint64_t maxQueueDepth = 0;
+        uint64_t writeCalls = 0;
+        uint64_t bytes = 0;
+    };
+
+private:
+    struct Argument {
+        enum Type : uint8_t { Signed, Unsigned, Floating, String } type;
+        union {
+            int64_t signedValue;
+            uint64_t unsignedValue;
+            double floatingValue;
+            char stringValue[STRING_BYTES];
+        };
+    };
+
+    struct Record {
+        const char* format;    // nullptr for text records
+        uint16_t length;       // text bytes for text records
+        uint8_t argumentCount;
+        union {
+            char text[TEXT_BYTES];
+            Argument arguments[MAX_ARGUMENTS];
+        };
+    };
+
+    // Single-producer/single-consumer ring owned by one logging thread
+    struct Ring {
+        alignas(64) std::atomic<uint64_t> tail{0};    // written by the producer
+        std::atomic<uint64_t> dropped{0};
+        std::atomic<uint64_t> maxDepth{0};
+        alignas(64) std::atomic<uint64_t> head{0};    // written by the flusher
+        std::atomic<bool> released{false};
+        bool recycled = false;                        // guarded by registryMutex_
+        Record records[RING_CAPACITY];
+    };
+
+    // Returns a thread's ring to the free list when the thread exits
+    struct RingHandle {
+        Ring* ring = nullptr;
+        ~RingHandle() {
+            if (ring != nullptr) {
+                ring->released.store(true, std::memory_order_release);
+            }
+        }
+    };
+
+    // Output buffer that never overflows; text past the end is cut off
+    struct LineBuffer {
+        char* data;
+        size_t capacity;
+        size_t size = 0;
+
+        void append(const char* text, size_t length) {
+            length = std::min(length, capacity - size);
+            std::memcpy(data + size, text, length);
+            size += length;
+        }
+    };
+
+    std::mutex registryMutex_;
+    std::vector<std::unique_ptr<Ring>> rings_;
+    std::vector<Ring*> freeRings_;
+    std::atomic<bool> binary_{false};
+    std::atomic<bool> dropWhenFull_{false};
+    std::atomic<bool> stopping_{false};
+    std::thread flusher_;
+    int fd_ = 1;
+
+    // Flusher-side totals
+    std::atomic<uint64_t> lines_{0};
+    std::atomic<uint64_t> retiredDropped_{0};
+    std::atomic<uint64_t> retiredMaxDepth_{0};
+    std::atomic<uint64_t> writeCalls_{0};
+    std::atomic<uint64_t> bytes_{0};
+
+    // flush() support: callers bump the request, the flusher publishes the
+    // request it has fully drained
+    std::mutex flushMutex_;
+    std::condition_variable flushed_;
+    uint64_t flushRequested_ = 0;
+    uint64_t flushCompleted_ = 0;
+
+    static void appendValue(LineBuffer& out, int64_t value) {
+        char digits[24];
+        auto result = std::to_chars(digits, digits + sizeof(digits), value);
+        out.append(digits, static_cast<size_t>(result.ptr - digits));
+    }
+
+    static void appendValue(LineBuffer& out, uint64_t value) {
+        char digits[24];
+        auto result = std::to_chars(digits, digits + sizeof(digits), value);
+        out.append(digits, static_cast<size_t>(result.ptr - digits));
+    }
+
+    static void appendValue(LineBuffer& out, double value) {
+        char digits[32];
+        int length = std::snprintf(digits, sizeof(digits), "%g", value);
+        out.append(digits, length > 0 ? static_cast<size_t>(length) : 0);
+    }
+
+    static void appendValue(LineBuffer& out, const char* value) {
+        out.append(value, std::strlen(value));
+    }
+
+    static void appendValue(LineBuffer& out, const std::string& value) {
+        out.append(value.data(), value.size());
+    }
+
+    template <typename T>
+    static void appendValue(LineBuffer& out, const T& value) {
+        static_assert(std::is_arithmetic<T>::value, "unsupported log argument type");
+        if constexpr (std::is_floating_point<T>::value) {
+            appendValue(out, static_cast<double>(value));
+        } else if constexpr (std::is_signed<T>::value) {
+            appendValue(out, static_cast<int64_t>(value));
+        } else {
+            appendValue(out, static_cast<uint64_t>(value));
+        }
+    }
+
+    static void appendArgument(LineBuffer& out, const Argument& argument) {
+        switch (argument.type) {
+            case Argument::Signed: appendValue(out, argument.signedValue); break;
+            case Argument::Unsigned: appendValue(out, argument.unsignedValue); break;
+            case Argument::Floating: appendValue(out, argument.floatingValue); break;
+            case Argument::String:
+                out.append(argument.stringValue, strnlen(argument.stringValue, STRING_BYTES));
+                break;
+        }
+    }
+
+    // Copies format text up to the next "{}" and returns what follows it
+    static const char* appendUntilPlaceholder(LineBuffer& out, const char* format) {
+        const char* placeholder = std::strstr(format, "{}");
+        if (placeholder == nullptr) {
+            out.append(format, std::strlen(format));
+            return nullptr;
+        }
+        out.append(format, static_cast<size_t>(placeholder - format));
+        return placeholder + 2;
+    }
+
+    static void formatText(LineBuffer& out, const char* format) {
+        if (format != nullptr) {
+            out.append(format, std::strlen(format));
+        }
+    }
+
+    template <typename First, typename... Rest>
+    static void formatText(LineBuffer& out, const char* format, const First& first,
+                           const Rest&... rest) {
+        if (format == nullptr) {
+            return;
+        }
+        const char* remaining = appendUntilPlaceholder(out, format);
+        if (remaining != nullptr) {
+            appendValue(out, first);
+            formatText(out, remaining, rest...);
+        }
+    }
+
+    static void formatBinary(LineBuffer& out, const Record& record) {
+        const char* format = record.format;
+        for (uint8_t i = 0; i < record.argumentCount && format != nullptr; ++i) {
+            format = appendUntilPlaceholder(out, format);
+            if (format != nullptr) {
+                appendArgument(out, record.arguments[i]);
+            }
+        }
+        if (format != nullptr) {
+            out.append(format, std::strlen(format));
+        }
+    }
+
+    static void capture(Argument& argument, const char* value) {
+        argument.type = Argument::String;
+        size_t length = strnlen(value, STRING_BYTES + 1);
+        if (length <= STRING_BYTES) {
+            std::strncpy(argument.stringValue, value, STRING_BYTES);
+            return;
+        }
+        // Mark the cut so a shortened name is not mistaken for a whole one
+        std::memcpy(argument.stringValue, value, STRING_BYTES - 3);
+        std::memcpy(argument.stringValue + STRING_BYTES - 3, "...", 3);
+    }
+
+    static void capture(Argument& argument, const std::string& value) {
+        capture(argument, value.c_str());
+    }
+
+    template <typename T>
+    static void capture(Argument& argument, const T& value) {
+        static_assert(std::is_arithmetic<T>::value, "unsupported log argument type");
+        if constexpr (std::is_floating_point<T>::value) {
+            argument.type = Argument::Floating;
+            argument.floatingValue = static_cast<double>(value);
+        } else if constexpr (std::is_signed<T>::value) {
+            argument.type = Argument::Signed;
+            argument.signedValue = static_cast<int64_t>(value);
+        } else {
+            argument.type = Argument::Unsigned;
+            argument.unsignedValue = static_cast<uint64_t>(value);
+        }
+    }
+
+    Ring* acquireRing() {
+        std::lock_guard<std::mutex> guard(registryMutex_);
+        if (!freeRings_.empty()) {
+            Ring* ring = freeRings_.back();
+            freeRings_.pop_back();
+            ring->released.store(false, std::memory_order_relaxed);
+            ring->recycled = false;
+            return ring;
+        }
+        rings_.push_back(std::make_unique<Ring>());
+        return rings_.back().get();
+    }
+
+    Ring& threadRing() {
+        static thread_local RingHandle handle;
+        if (handle.ring == nullptr) {
+            handle.ring = acquireRing();
+        }
+        return *handle.ring;
+    }
+
+    void writeBuffer(LineBuffer& buffer) {
+        size_t written = 0;
+        while (written < buffer.size) {
+#ifdef _WIN32
+            int result = _write(fd_, buffer.data + written, static_cast<unsigned>(buffer.size - written));
+#else
+            ssize_t result = ::write(fd_, buffer.data + written, buffer.size - written);
+#endif
+            if (result <= 0) {
+                break;
+            }
+            written += static_cast<size_t>(result);
+        }
+        writeCalls_.fetch_add(1, std::memory_order_relaxed);
+        bytes_.fetch_add(buffer.size, std::memory_order_relaxed);
+        buffer.size = 0;
+    }
+
+    // Moves every queued record into the write buffer; returns lines drained
+    uint64_t drainRings(LineBuffer& buffer) {
+        uint64_t drained = 0;
+        std::lock_guard<std::mutex> guard(registryMutex_);
+
+        for (auto& ringPointer : rings_) {
+            Ring& ring = *ringPointer;
+            bool released = ring.released.load(std::memory_order_acquire);
+            uint64_t head = ring.head.load(std::memory_order_relaxed);
+            uint64_t tail = ring.tail.load(std::memory_order_acquire);
+
+            for (; head != tail; ++head) {
+                // Leave room for the longest possible line before formatting
+                if (buffer.capacity - buffer.size < TEXT_BYTES + MAX_ARGUMENTS * 32 + 1) {
+                    writeBuffer(buffer);
+                }
+                const Record& record = ring.records[head % RING_CAPACITY];
+                if (record.format == nullptr) {
+                    buffer.append(record.text, record.length);
+                } else {
+                    formatBinary(buffer, record);
+                }
+                buffer.append("\n", 1);
+                ++drained;
+            }
+            ring.head.store(head, std::memory_order_release);
+
+            // Recycle rings of exited threads once they are empty
+            if (released && !ring.recycled) {
+                retiredDropped_.fetch_add(ring.dropped.exchange(0), std::memory_order_relaxed);
+                uint64_t depth = ring.maxDepth.exchange(0);
+                uint64_t previous = retiredMaxDepth_.load(std::memory_order_relaxed);
+                while (depth > previous &&
+                       !retiredMaxDepth_.compare_exchange_weak(previous, depth)) {
+                }
+                ring.recycled = true;
+                freeRings_.push_back(&ring);
+            }
+        }
+        lines_.fetch_add(drained, std::memory_order_relaxed);
+        return drained;
+    }
+
+    void flusherLoop() {
+        std::vector<char> storage(WRITE_BUFFER_BYTES);
+        LineBuffer buffer{storage.data(), storage.size()};
+
+        while (true) {
+            uint64_t requested;
+            {
+                std::lock_guard<std::mutex> guard(flushMutex_);
+                requested = flushRequested_;
+            }
+            bool stopping = stopping_.load(std::memory_order_acquire);
+
+            uint64_t drained = drainRings(buffer);
+            if (buffer.size > 0) {
+                writeBuffer(buffer);
+            }
+
+            {
+                std::lock_guard<std::mutex> guard(flushMutex_);
+                flushCompleted_ = requested;
+            }
+            flushed_.notify_all();
+
+            if (stopping) {
+                return;
+            }
+            if (drained == 0) {
+                std::unique_lock<std::mutex> lock(flushMutex_);
+                flushed_.wait_for(lock, FLUSH_INTERVAL, [this]() {
+                    return flushRequested_ != flushCompleted_ || stopping_.load();
+                });
+            }
+        }
+    }
+
+    AsyncLogger() {
+        flusher_ = std::thread(&AsyncLogger::flusherLoop, this);
+    }
+
+public:
+    AsyncLogger(const AsyncLogger&) = delete;
+    AsyncLogger& operator=(const AsyncLogger&) = delete;
+
+    ~AsyncLogger() {
+        stop();
+    }
+
+    static AsyncLogger& instance() {
+        static AsyncLogger logger;
+        return logger;
+    }
+
+    // Binary records defer all formatting to the flusher thread
+    void setBinary(bool binary) {
+        binary_.store(binary, std::memory_order_relaxed);
+    }
+
+    // Drops lines while a ring is full instead of waiting for the flusher
+    void setDropWhenFull(bool drop) {
+        dropWhenFull_.store(drop, std::memory_order_relaxed);
+    }
+
+    void setOutput(int fd) {
+        std::lock_guard<std::mutex> guard(registryMutex_);
+        fd_ = fd;
+    }
+
+    // Queues one line; a trailing newline is added by the logger. Waits for
+    // room while the ring is full, unless setDropWhenFull() is on
+    template <typename... Args>
+    void log(const char* format, const Args&... args) {
+        static_assert(sizeof...(Args) <= MAX_ARGUMENTS, "too many log arguments");
+        Ring& ring = threadRing();
+        uint64_t tail = ring.tail.load(std::memory_order_relaxed);
+        uint64_t head = ring.head.load(std::memory_order_acquire);
+
+        while (tail - head >= RING_CAPACITY) {
+            // Nobody will drain the ring once the flusher is stopping
+            if (dropWhenFull_.load(std::memory_order_relaxed) ||
+                stopping_.load(std::memory_order_relaxed)) {
+                ring.dropped.store(ring.dropped.load(std::memory_order_relaxed) + 1,
+                                   std::memory_order_relaxed);
+                return;
+            }
+            std::this_thread::yield();
+            head = ring.head.load(std::memory_order_acquire);
+        }
+
+        Record& record = ring.records[tail % RING_CAPACITY];
+        if (binary_.load(std::memory_order_relaxed)) {
+            record.format = format;
+            record.argumentCount = 0;
+            (capture(record.arguments[record.argumentCount++], args), ...);
+        } else {
+            LineBuffer text{record.text, TEXT_BYTES};
+            formatText(text, format, args...);
+            record.format = nullptr;
+            record.length = static_cast<uint16_t>(text.size);
+        }
+        ring.tail.store(tail + 1, std::memory_order_release);
+
+        uint64_t depth = tail + 1 - head;
+        if (depth > ring.maxDepth.load(std::memory_order_relaxed)) {
+            ring.maxDepth.store(depth, std::memory_order_relaxed);
+        }
+    }
+
+    // Blocks until everything logged before the call has been written
+    void flush() {
+        std::unique_lock<std::mutex> lock(flushMutex_);
+        if (!flusher_.joinable()) {
+            return;
+        }
+        uint64_t request = ++flushRequested_;
+        flushed_.notify_all();
+        flushed_.wait(lock, [&]() { return flushCompleted_ >= request; });
+    }
+
+    // Drains all rings and stops the flusher; later lines are not written
+    void stop() {
+        if (!flusher_.joinable()) {
+            return;
+        }
+        stopping_.store(true, std::memory_order_release);
+        flushed_.notify_all();
+        flusher_.join();
+    }
+
+    Stats stats() {
+        Stats stats;
+        stats.lines = lines_.load();
+        stats.dropped = retiredDropped_.load();
+        stats.maxQueueDepth = retiredMaxDepth_.load();
+        stats.writeCalls = writeCalls_.load();
+        stats.bytes = bytes_.load();
+
+        std::lock_guard<std::mutex> guard(registryMutex_);
+        for (auto& ring : rings_) {
+            stats.dropped += ring->dropped.load(std::memory_order_relaxed);
+            stats.maxQueueDepth = std::max(stats.maxQueueDepth,
+                                           ring->maxDepth.load(std::memory_order_relaxed));
+            stats.queueDepth += ring->tail.load() - ring->head.load();
+        }
+        return stats;
+    }
+};
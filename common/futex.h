@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#ifdef __linux__
+    #include <linux/futex.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+    #include <climits>
+    #include <ctime>
+#else
+    #include <chrono>
+    #include <thread>
+#endif
+
+// Minimal futex wrappers around a 32-bit atomic word. With processShared the
+// word may live in memory shared between processes (MAP_SHARED); otherwise the
+// cheaper process-private futex is used. On systems without futexes waiting
+// degrades to a short sleep, so callers must always re-check their condition.
+
+// Blocks while *word still equals expected (or until woken / interrupted /
+// timeoutNs elapsed, when timeoutNs >= 0)
+inline void futexWait(std::atomic<uint32_t>* word, uint32_t expected, bool processShared,
+                      int64_t timeoutNs = -1) {
+#ifdef __linux__
+    int operation = processShared ? FUTEX_WAIT : FUTEX_WAIT_PRIVATE;
+    timespec timeout{static_cast<time_t>(timeoutNs / 1000000000),
+                     static_cast<long>(timeoutNs % 1000000000)};
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), operation, expected,
+            timeoutNs >= 0 ? &timeout : nullptr, nullptr, 0);
+#else
+    (void)processShared;
+    if (word->load(std::memory_order_acquire) == expected) {
+        int64_t sleepNs = timeoutNs >= 0 && timeoutNs < 50000 ? timeoutNs : 50000;
+        std::this_thread::sleep_for(std::chrono::nanoseconds(sleepNs));
+    }
+#endif
+}
+
+// Wakes up to count waiters blocked on word
+inline void futexWake(std::atomic<uint32_t>* word, int count, bool processShared) {
+#ifdef __linux__
+    int operation = processShared ? FUTEX_WAKE : FUTEX_WAKE_PRIVATE;
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), operation, count, nullptr, nullptr, 0);
+#else
+    (void)word;
+    (void)count;
+    (void)processShared;
+#endif
+}
+
+inline void futexWakeAll(std::atomic<uint32_t>* word, bool processShared) {
+#ifdef __linux__
+    futexWake(word, INT_MAX, processShared);
+#else
+    futexWake(word, 0, processShared);
+#endif
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+
+#ifdef _MSC_VER
+    #include <intrin.h>
+#endif
+
+// Fixed-size log-linear latency histogram (HDR style). Values below
+// 2^SUB_BUCKET_BITS nanoseconds get exact buckets; above that every power of
+// two is split into 2^SUB_BUCKET_BITS linear sub-buckets, which bounds the
+// relative error to about 3%. The layout is plain data, so a histogram can
+// live in memory shared with forked children.
+class LatencyHistogram {
+public:
+    static constexpr int SUB_BUCKET_BITS = 5;
+    static constexpr int SUB_BUCKET_COUNT = 1 << SUB_BUCKET_BITS;
+    static constexpr int MAX_VALUE_BITS = 40;  // about 18 minutes in nanoseconds
+    static constexpr int BUCKET_COUNT = (MAX_VALUE_BITS - SUB_BUCKET_BITS + 1) * SUB_BUCKET_COUNT;
+
+private:
+    std::array<uint64_t, BUCKET_COUNT> counts_{};
+    uint64_t total_ = 0;
+    uint64_t max_ = 0;
+    uint64_t sum_ = 0;
+
+    static int highestBit(uint64_t value) {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanReverse64(&index, value);
+        return static_cast<int>(index);
+#else
+        return 63 - __builtin_clzll(value);
+#endif
+    }
+
+    static int bucketIndex(uint64_t value) {
+        if (value < static_cast<uint64_t>(SUB_BUCKET_COUNT)) {
+            return static_cast<int>(value);
+        }
+        int topBit = highestBit(value);
+        if (topBit >= MAX_VALUE_BITS) {
+            return BUCKET_COUNT - 1;
+        }
+        int shift = topBit - SUB_BUCKET_BITS;
+        int subBucket = static_cast<int>(value >> shift) - SUB_BUCKET_COUNT;
+        return (shift + 1) * SUB_BUCKET_COUNT + subBucket;
+    }
+
+    // Highest value that falls into the given bucket
+    static uint64_t bucketUpperBound(int index) {
+        if (index < SUB_BUCKET_COUNT) {
+            return static_cast<uint64_t>(index);
+        }
+        int shift = index / SUB_BUCKET_COUNT - 1;
+        uint64_t subBucket = static_cast<uint64_t>(index % SUB_BUCKET_COUNT + SUB_BUCKET_COUNT);
+        return ((subBucket + 1) << shift) - 1;
+    }
+
+public:
+    void record(uint64_t nanoseconds) {
+        ++counts_[bucketIndex(nanoseconds)];
+        ++total_;
+        sum_ += nanoseconds;
+        max_ = std::max(max_, nanoseconds);
+    }
+
+    void merge(const LatencyHistogram& other) {
+        for (int i = 0; i < BUCKET_COUNT; ++i) {
+            counts_[i] += other.counts_[i];
+        }
+        total_ += other.total_;
+        sum_ += other.sum_;
+        max_ = std::max(max_, other.max_);
+    }
+
+    void reset() {
+        counts_.fill(0);
+        total_ = 0;
+        sum_ = 0;
+        max_ = 0;
+    }
+
+    uint64_t count() const {
+        return total_;
+    }
+
+    uint64_t max() const {
+        return max_;
+    }
+
+    double mean() const {
+        return total_ == 0 ? 0.0 : static_cast<double>(sum_) / total_;
+    }
+
+    // Value at the given percentile (0-100), reported as its bucket's upper bound
+    uint64_t percentile(double percent) const {
+        if (total_ == 0) {
+            return 0;
+        }
+        uint64_t target = static_cast<uint64_t>(percent / 100.0 * total_ + 0.5);
+        target = std::max<uint64_t>(1, std::min(target, total_));
+
+        uint64_t seen = 0;
+        for (int i = 0; i < BUCKET_COUNT; ++i) {
+            seen += counts_[i];
+            if (seen >= target) {
+                return std::min(bucketUpperBound(i), max_);
+            }
+        }
+        return max_;
+    }
+};
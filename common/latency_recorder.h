@@ -0,0 +1,236 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "latency_histogram.h"
+
+// Always-on latency instrumentation. Code names a measurement point once
+// (metric("lock.wait")) and then records nanoseconds into a histogram owned
+// by the calling thread: no lock, no atomic read-modify-write, no shared
+// cache line, just a bucket increment. A thread registers a histogram the
+// first time it records a metric; when it exits its histograms are folded
+// into per-metric totals. writeJson() merges everything into percentiles,
+// and dumpJsonAtExit() does so once the program ends.
+//
+// Each clock read costs tens of nanoseconds, which is as much as an
+// uncontended lock. Hot call sites therefore ask sample() first: with a
+// sample interval of N only every Nth call per thread takes timestamps.
+//
+// Reports are meant to be taken once the recording threads have finished
+// (at exit, after joins); a report taken while they run may be slightly off.
+class LatencyRecorder {
+public:
+    static constexpr int MAX_METRICS = 32;
+
+private:
+    // One thread's histograms, allocated per metric on first use
+    struct ThreadHistograms {
+        std::unique_ptr<LatencyHistogram> histograms[MAX_METRICS];
+        bool retired = false;  // guarded by registryMutex_
+    };
+
+    // Folds a thread's histograms into the totals when the thread exits
+    struct ThreadHandle {
+        ThreadHistograms* histograms = nullptr;
+        ~ThreadHandle() {
+            if (histograms != nullptr) {
+                LatencyRecorder::instance().retire(histograms);
+            }
+        }
+    };
+
+    std::mutex registryMutex_;
+    std::vector<std::string> names_;
+    std::vector<std::unique_ptr<ThreadHistograms>> threads_;
+    std::vector<ThreadHistograms*> freeThreads_;  // retired, ready for a new thread
+    LatencyHistogram retired_[MAX_METRICS];
+    std::atomic<bool> enabled_{true};
+    std::atomic<uint32_t> sampleInterval_{1};
+    std::string exitPath_;
+
+    LatencyRecorder() = default;
+
+    ThreadHistograms& threadHistograms() {
+        static thread_local ThreadHandle handle;
+        if (handle.histograms == nullptr) {
+            std::lock_guard<std::mutex> guard(registryMutex_);
+            if (!freeThreads_.empty()) {
+                handle.histograms = freeThreads_.back();
+                freeThreads_.pop_back();
+                handle.histograms->retired = false;
+            } else {
+                threads_.push_back(std::make_unique<ThreadHistograms>());
+                handle.histograms = threads_.back().get();
+            }
+        }
+        return *handle.histograms;
+    }
+
+    void retire(ThreadHistograms* histograms) {
+        std::lock_guard<std::mutex> guard(registryMutex_);
+        for (int i = 0; i < MAX_METRICS; ++i) {
+            if (histograms->histograms[i]) {
+                retired_[i].merge(*histograms->histograms[i]);
+                histograms->histograms[i].reset();
+            }
+        }
+        histograms->retired = true;
+        freeThreads_.push_back(histograms);
+    }
+
+    static void dumpAtExit() {
+        LatencyRecorder& recorder = instance();
+        if (recorder.exitPath_ == "-") {
+            recorder.writeJson(std::cout);
+        } else {
+            std::ofstream out(recorder.exitPath_);
+            if (!out) {
+                std::cerr << "Cannot write latency report to " << recorder.exitPath_ << "\n";
+                return;
+            }
+            recorder.writeJson(out);
+        }
+    }
+
+public:
+    LatencyRecorder(const LatencyRecorder&) = delete;
+    LatencyRecorder& operator=(const LatencyRecorder&) = delete;
+
+    static LatencyRecorder& instance() {
+        static LatencyRecorder recorder;
+        return recorder;
+    }
+
+    static uint64_t now() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    // Id of the named measurement point, registering it on first use. Look it
+    // up once (a static local) rather than on every record.
+    int metric(const std::string& name) {
+        std::lock_guard<std::mutex> guard(registryMutex_);
+        for (size_t i = 0; i < names_.size(); ++i) {
+            if (names_[i] == name) {
+                return static_cast<int>(i);
+            }
+        }
+        if (names_.size() == MAX_METRICS) {
+            throw std::length_error("too many latency metrics");
+        }
+        names_.push_back(name);
+        return static_cast<int>(names_.size() - 1);
+    }
+
+    // Recording is on by default. Call sites check enabled() or sample()
+    // before reading the clock, so a disabled recorder costs one relaxed load.
+    void setEnabled(bool enabled) {
+        enabled_.store(enabled, std::memory_order_relaxed);
+    }
+
+    bool enabled() const {
+        return enabled_.load(std::memory_order_relaxed);
+    }
+
+    // Times only one call in interval (per thread) at sites that use sample()
+    void setSampleInterval(uint32_t interval) {
+        sampleInterval_.store(interval == 0 ? 1 : interval, std::memory_order_relaxed);
+    }
+
+    uint32_t sampleInterval() const {
+        return sampleInterval_.load(std::memory_order_relaxed);
+    }
+
+    // True when this call should be timed: recording is enabled and this
+    // thread's countdown reached zero
+    bool sample() {
+        static thread_local uint32_t countdown = 0;
+        if (!enabled()) {
+            return false;
+        }
+        if (countdown != 0) {
+            --countdown;
+            return false;
+        }
+        countdown = sampleInterval() - 1;
+        return true;
+    }
+
+    void record(int metric, uint64_t nanoseconds) {
+        if (!enabled()) {
+            return;
+        }
+        std::unique_ptr<LatencyHistogram>& histogram = threadHistograms().histograms[metric];
+        if (!histogram) {
+            auto created = std::make_unique<LatencyHistogram>();
+            std::lock_guard<std::mutex> guard(registryMutex_);
+            histogram = std::move(created);
+        }
+        histogram->record(nanoseconds);
+    }
+
+    // Records the time elapsed since startNs, a value from now()
+    void recordSince(int metric, uint64_t startNs) {
+        record(metric, now() - startNs);
+    }
+
+    // Merged histogram of one metric across live and exited threads
+    LatencyHistogram merged(int metric) {
+        std::lock_guard<std::mutex> guard(registryMutex_);
+        LatencyHistogram total = retired_[metric];
+        for (const auto& thread : threads_) {
+            if (!thread->retired && thread->histograms[metric]) {
+                total.merge(*thread->histograms[metric]);
+            }
+        }
+        return total;
+    }
+
+    // {"metric": {"count": N, "mean_ns": ..., "p50_ns": ..., ...}, ...};
+    // counts are samples, see "sample_interval"
+    void writeJson(std::ostream& out) {
+        std::vector<std::string> names;
+        {
+            std::lock_guard<std::mutex> guard(registryMutex_);
+            names = names_;
+        }
+
+        out << "{\n  \"sample_interval\": " << sampleInterval();
+        for (size_t i = 0; i < names.size(); ++i) {
+            LatencyHistogram histogram = merged(static_cast<int>(i));
+            char line[320];
+            std::snprintf(line, sizeof(line),
+                          ",\n  \"%s\": {\"count\": %llu, \"mean_ns\": %.1f, \"p50_ns\": %llu, "
+                          "\"p90_ns\": %llu, \"p99_ns\": %llu, \"p999_ns\": %llu, \"max_ns\": %llu}",
+                          names[i].c_str(),
+                          static_cast<unsigned long long>(histogram.count()), histogram.mean(),
+                          static_cast<unsigned long long>(histogram.percentile(50)),
+                          static_cast<unsigned long long>(histogram.percentile(90)),
+                          static_cast<unsigned long long>(histogram.percentile(99)),
+                          static_cast<unsigned long long>(histogram.percentile(99.9)),
+                          static_cast<unsigned long long>(histogram.max()));
+            out << line;
+        }
+        out << "\n}\n";
+    }
+
+    // Writes the JSON report to path ("-" for stdout) when the program exits
+    void dumpJsonAtExit(const std::string& path) {
+        bool registered = !exitPath_.empty();
+        exitPath_ = path;
+        if (!registered) {
+            std::atexit(&LatencyRecorder::dumpAtExit);
+        }
+    }
+};
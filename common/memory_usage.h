@@ -0,0 +1,59 @@
+#pragma once
+
+#include <fstream>
+#include <sstream>
+#include <string>
+
+// Memory counters of the current process, in kilobytes (0 when unavailable)
+struct MemoryUsage {
+    long rssKb = 0;
+    long peakRssKb = 0;
+    long virtualKb = 0;
+    long peakVirtualKb = 0;
+};
+
+// Reads the process memory counters from /proc/self/status (Linux only)
+inline MemoryUsage readMemoryUsage() {
+    MemoryUsage usage;
+    std::ifstream status("/proc/self/status");
+    std::string line;
+
+    while (std::getline(status, line)) {
+        std::istringstream fields(line);
+        std::string key;
+        long value = 0;
+        fields >> key >> value;
+
+        if (key == "VmRSS:") {
+            usage.rssKb = value;
+        } else if (key == "VmHWM:") {
+            usage.peakRssKb = value;
+        } else if (key == "VmSize:") {
+            usage.virtualKb = value;
+        } else if (key == "VmPeak:") {
+            usage.peakVirtualKb = value;
+        }
+    }
+    return usage;
+}
+
+// Kernel slab memory of the whole system from /proc/meminfo, in kilobytes (0
+// when unavailable). Sockets, their queued buffers, files and inodes live
+// there, none of which shows up in a process's RSS. Other processes change
+// it too, so only deltas over a quiet interval mean anything.
+inline long readKernelSlabKb() {
+    std::ifstream meminfo("/proc/meminfo");
+    std::string line;
+
+    while (std::getline(meminfo, line)) {
+        std::istringstream fields(line);
+        std::string key;
+        long value = 0;
+        fields >> key >> value;
+
+        if (key == "Slab:") {
+            return value;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,183 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <type_traits>
+
+// Bounded lock-free multi-producer/multi-consumer ring (Dmitry Vyukov's
+// design). Every cell carries a sequence number that tells producers and
+// consumers whether the cell is free for the current lap, so each push or
+// pop costs one CAS on the shared position plus one store on the cell.
+//
+// The batch operations claim a run of consecutive cells with a single CAS,
+// so the shared positions are touched once per batch rather than once per
+// element.
+//
+// The ring is a fixed-size plain object with no heap allocation, so it can be
+// placement-constructed inside a MAP_SHARED region and used across fork().
+template <typename T, size_t Capacity>
+class MpmcRing {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+                  "capacity must be a power of two");
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "elements are copied between processes");
+    static_assert(std::atomic<size_t>::is_always_lock_free,
+                  "positions must be lock-free to work across processes");
+
+private:
+    static constexpr size_t CACHE_LINE_SIZE = 64;
+    static constexpr size_t MASK = Capacity - 1;
+
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T data;
+    };
+
+    alignas(CACHE_LINE_SIZE) Cell cells_[Capacity];
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> enqueuePosition_{0};
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> dequeuePosition_{0};
+
+    // A batch may claim cells whose previous owner is still copying; that
+    // takes nanoseconds unless the owner was preempted, hence the yield
+    static void waitForSequence(const Cell& cell, size_t expected) {
+        while (cell.sequence.load(std::memory_order_acquire) != expected) {
+            std::this_thread::yield();
+        }
+    }
+
+public:
+    MpmcRing() {
+        for (size_t i = 0; i < Capacity; ++i) {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MpmcRing(const MpmcRing&) = delete;
+    MpmcRing& operator=(const MpmcRing&) = delete;
+
+    static constexpr size_t capacity() {
+        return Capacity;
+    }
+
+    // Returns false when the ring is full
+    bool tryPush(const T& value) {
+        size_t position = enqueuePosition_.load(std::memory_order_relaxed);
+        while (true) {
+            Cell& cell = cells_[position & MASK];
+            size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+
+            if (difference == 0) {
+                if (enqueuePosition_.compare_exchange_weak(position, position + 1,
+                                                           std::memory_order_relaxed)) {
+                    cell.data = value;
+                    cell.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (difference < 0) {
+                return false;
+            } else {
+                position = enqueuePosition_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Returns false when the ring is empty
+    bool tryPop(T& value) {
+        size_t position = dequeuePosition_.load(std::memory_order_relaxed);
+        while (true) {
+            Cell& cell = cells_[position & MASK];
+            size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            intptr_t difference =
+                static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position + 1);
+
+            if (difference == 0) {
+                if (dequeuePosition_.compare_exchange_weak(position, position + 1,
+                                                           std::memory_order_relaxed)) {
+                    value = cell.data;
+                    cell.sequence.store(position + MASK + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (difference < 0) {
+                return false;
+            } else {
+                position = dequeuePosition_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Pushes up to count values in order and returns how many fit (0 when
+    // the ring is full). The claim is checked against the last cell of the
+    // run: once that cell is free for this lap, every earlier cell has been
+    // claimed by a consumer and is at most a copy away from being released.
+    size_t tryPushBatch(const T* values, size_t count) {
+        size_t position = enqueuePosition_.load(std::memory_order_relaxed);
+        while (true) {
+            size_t dequeued = dequeuePosition_.load(std::memory_order_relaxed);
+            if (dequeued > position) {
+                position = enqueuePosition_.load(std::memory_order_relaxed);  // stale
+                continue;
+            }
+            size_t used = position - dequeued;
+            size_t run = std::min(count, used < Capacity ? Capacity - used : 0);
+            if (run == 0) {
+                return 0;
+            }
+            size_t last = position + run - 1;
+            size_t sequence = cells_[last & MASK].sequence.load(std::memory_order_acquire);
+            if (sequence == last) {
+                if (enqueuePosition_.compare_exchange_weak(position, position + run,
+                                                           std::memory_order_relaxed)) {
+                    for (size_t i = 0; i < run; ++i) {
+                        Cell& cell = cells_[(position + i) & MASK];
+                        waitForSequence(cell, position + i);
+                        cell.data = values[i];
+                        cell.sequence.store(position + i + 1, std::memory_order_release);
+                    }
+                    return run;
+                }
+            } else {
+                position = enqueuePosition_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Pops up to count values in order and returns how many were taken (0
+    // when the ring is empty)
+    size_t tryPopBatch(T* values, size_t count) {
+        size_t position = dequeuePosition_.load(std::memory_order_relaxed);
+        while (true) {
+            size_t enqueued = enqueuePosition_.load(std::memory_order_acquire);
+            size_t run = std::min(count, enqueued > position ? enqueued - position : 0);
+            if (run == 0) {
+                return 0;
+            }
+            size_t last = position + run - 1;
+            size_t sequence = cells_[last & MASK].sequence.load(std::memory_order_acquire);
+            if (sequence == last + 1) {
+                if (dequeuePosition_.compare_exchange_weak(position, position + run,
+                                                           std::memory_order_relaxed)) {
+                    for (size_t i = 0; i < run; ++i) {
+                        Cell& cell = cells_[(position + i) & MASK];
+                        waitForSequence(cell, position + i + 1);
+                        values[i] = cell.data;
+                        cell.sequence.store(position + i + MASK + 1, std::memory_order_release);
+                    }
+                    return run;
+                }
+            } else {
+                position = dequeuePosition_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Approximate number of queued elements
+    size_t size() const {
+        size_t enqueued = enqueuePosition_.load(std::memory_order_relaxed);
+        size_t dequeued = dequeuePosition_.load(std::memory_order_relaxed);
+        return enqueued > dequeued ? enqueued - dequeued : 0;
+    }
+};
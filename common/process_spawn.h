@@ -0,0 +1,192 @@
+#pragma once
+
+#ifndef _WIN32
+
+#include <cerrno>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+#include <spawn.h>
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#ifdef __linux__
+    #include <sched.h>
+    #include <csignal>
+#endif
+
+extern char** environ;
+
+// Ways to start a child process, selectable at runtime:
+//   fork         fork() then exec: the kernel copies the parent's page tables
+//                (and marks every page copy-on-write), so the cost grows
+//                with the parent's resident memory
+//   fork_noexec  fork() and run in place, how the labs start their workers
+//   vfork        the child borrows the parent's address space until it execs;
+//                the parent is suspended meanwhile and nothing is copied
+//   posix_spawn  the libc wrapper; glibc implements it with clone(CLONE_VM |
+//                CLONE_VFORK), so it costs about what vfork does
+//   clone        clone(CLONE_VM | CLONE_VFORK) on a small private stack, so
+//                the child cannot scribble over the parent's stack (Linux)
+// Every method except fork_noexec runs the given program.
+
+enum class SpawnMethod { Fork, ForkNoExec, Vfork, PosixSpawn, Clone };
+
+inline const char* spawnMethodName(SpawnMethod method) {
+    switch (method) {
+        case SpawnMethod::Fork: return "fork";
+        case SpawnMethod::ForkNoExec: return "fork_noexec";
+        case SpawnMethod::Vfork: return "vfork";
+        case SpawnMethod::PosixSpawn: return "posix_spawn";
+        case SpawnMethod::Clone: return "clone";
+    }
+    return "unknown";
+}
+
+// Methods available on this platform, in the order above
+inline std::vector<SpawnMethod> availableSpawnMethods() {
+    std::vector<SpawnMethod> methods{SpawnMethod::Fork, SpawnMethod::ForkNoExec,
+                                     SpawnMethod::Vfork, SpawnMethod::PosixSpawn};
+#ifdef __linux__
+    methods.push_back(SpawnMethod::Clone);
+#endif
+    return methods;
+}
+
+inline SpawnMethod parseSpawnMethod(const std::string& name) {
+    for (SpawnMethod method : availableSpawnMethods()) {
+        if (name == spawnMethodName(method)) {
+            return method;
+        }
+    }
+    throw std::invalid_argument("Unknown spawn method: " + name);
+}
+
+// Program and arguments for a child, prepared before the spawn because a
+// vfork or clone child shares the parent's memory and must not allocate
+class SpawnCommand {
+private:
+    std::vector<std::string> words_;
+    std::vector<char*> argv_;
+
+public:
+    explicit SpawnCommand(std::vector<std::string> words) : words_(std::move(words)) {
+        if (words_.empty()) {
+            throw std::invalid_argument("A spawn command needs a program");
+        }
+        for (std::string& word : words_) {
+            argv_.push_back(&word[0]);
+        }
+        argv_.push_back(nullptr);
+    }
+
+    SpawnCommand(const SpawnCommand&) = delete;
+    SpawnCommand& operator=(const SpawnCommand&) = delete;
+
+    const char* path() const {
+        return argv_[0];
+    }
+
+    char* const* argv() const {
+        return argv_.data();
+    }
+};
+
+// Starts a process with one spawn method. The clone stack is allocated once
+// and reused: CLONE_VFORK keeps the parent suspended until the child has
+// exec'd or exited, so two children never run on it at the same time.
+class ProcessSpawner {
+private:
+    static constexpr size_t CLONE_STACK_SIZE = 64 * 1024;
+
+    SpawnMethod method_;
+    void* cloneStack_ = nullptr;
+
+#ifdef __linux__
+    static int cloneChild(void* argument) {
+        const SpawnCommand* command = static_cast<const SpawnCommand*>(argument);
+        execve(command->path(), command->argv(), environ);
+        _exit(127);
+    }
+#endif
+
+public:
+    explicit ProcessSpawner(SpawnMethod method) : method_(method) {
+        if (method_ == SpawnMethod::Clone) {
+            cloneStack_ = mmap(nullptr, CLONE_STACK_SIZE, PROT_READ | PROT_WRITE,
+                               MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK, -1, 0);
+            if (cloneStack_ == MAP_FAILED) {
+                throw std::system_error(errno, std::generic_category(), "mmap clone stack");
+            }
+        }
+    }
+
+    ProcessSpawner(const ProcessSpawner&) = delete;
+    ProcessSpawner& operator=(const ProcessSpawner&) = delete;
+
+    ~ProcessSpawner() {
+        if (cloneStack_ != nullptr) {
+            munmap(cloneStack_, CLONE_STACK_SIZE);
+        }
+    }
+
+    SpawnMethod method() const {
+        return method_;
+    }
+
+    // Starts a child and returns its pid; the caller reaps it with waitpid.
+    // fork_noexec children exit with status 0 right away. Throws
+    // std::system_error when the process cannot be created; an exec failure
+    // shows up as exit status 127.
+    pid_t spawn(const SpawnCommand& command) {
+        pid_t pid = -1;
+        switch (method_) {
+            case SpawnMethod::Fork:
+                pid = fork();
+                if (pid == 0) {
+                    execve(command.path(), command.argv(), environ);
+                    _exit(127);
+                }
+                break;
+            case SpawnMethod::ForkNoExec:
+                pid = fork();
+                if (pid == 0) {
+                    _exit(0);
+                }
+                break;
+            case SpawnMethod::Vfork:
+                pid = vfork();
+                if (pid == 0) {
+                    execve(command.path(), command.argv(), environ);
+                    _exit(127);
+                }
+                break;
+            case SpawnMethod::PosixSpawn: {
+                int error = posix_spawn(&pid, command.path(), nullptr, nullptr, command.argv(),
+                                        environ);
+                if (error != 0) {
+                    throw std::system_error(error, std::generic_category(), "posix_spawn");
+                }
+                break;
+            }
+            case SpawnMethod::Clone:
+#ifdef __linux__
+                pid = clone(&ProcessSpawner::cloneChild,
+                            static_cast<char*>(cloneStack_) + CLONE_STACK_SIZE,
+                            CLONE_VM | CLONE_VFORK | SIGCHLD,
+                            const_cast<SpawnCommand*>(&command));
+#endif
+                break;
+        }
+        if (pid == -1) {
+            throw std::system_error(errno, std::generic_category(), spawnMethodName(method_));
+        }
+        return pid;
+    }
+};
+
+#endif
@@ -0,0 +1,173 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <random>
+#include <utility>
+
+// Small, fast random numbers for every lab. Xoshiro256 is xoshiro256**:
+// 32 bytes of state, a handful of shifts and multiplies per draw, and
+// seeding through splitmix64 so that any 64-bit seed gives a good state.
+// Streams are keyed by (master seed, stream number): the same pair always
+// yields the same sequence, and different stream numbers give unrelated
+// sequences, which is what makes parallel runs reproducible.
+//
+// threadRng() is a lazily seeded generator per thread. Code that needs
+// reproducible results pins its stream with seedThreadRng(n) (a job index,
+// a player id...). A forked child inherits its parent's generator and must
+// reseed it, or it replays the parent's numbers.
+
+inline uint64_t splitMix64(uint64_t& state) {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+class Xoshiro256 {
+private:
+    uint64_t s_[4];
+
+    static uint64_t rotl(uint64_t x, int k) {
+        return (x << k) | (x >> (64 - k));
+    }
+
+    // Lemire's multiply-shift: maps 32 random bits onto [0, bound); the
+    // rejection step (rarely taken) removes the bias
+    uint32_t bounded(uint32_t bits, uint32_t bound) {
+        uint64_t product = static_cast<uint64_t>(bits) * bound;
+        uint32_t low = static_cast<uint32_t>(product);
+        if (low < bound) {
+            uint32_t threshold = static_cast<uint32_t>(-bound) % bound;
+            while (low < threshold) {
+                product = static_cast<uint64_t>(next() >> 32) * bound;
+                low = static_cast<uint32_t>(product);
+            }
+        }
+        return static_cast<uint32_t>(product >> 32);
+    }
+
+public:
+    using result_type = uint64_t;
+
+    explicit Xoshiro256(uint64_t seed = 0, uint64_t stream = 0) {
+        this->seed(seed, stream);
+    }
+
+    void seed(uint64_t seed, uint64_t stream = 0) {
+        uint64_t streamState = stream;
+        uint64_t state = seed ^ splitMix64(streamState);
+        for (uint64_t& word : s_) {
+            word = splitMix64(state);
+        }
+    }
+
+    static constexpr uint64_t min() {
+        return 0;
+    }
+
+    static constexpr uint64_t max() {
+        return UINT64_MAX;
+    }
+
+    uint64_t next() {
+        uint64_t result = rotl(s_[1] * 5, 7) * 9;
+        uint64_t t = s_[1] << 17;
+        s_[2] ^= s_[0];
+        s_[3] ^= s_[1];
+        s_[1] ^= s_[2];
+        s_[0] ^= s_[3];
+        s_[2] ^= t;
+        s_[3] = rotl(s_[3], 45);
+        return result;
+    }
+
+    uint64_t operator()() {
+        return next();
+    }
+
+    // Uniform integer in [0, bound), bound > 0
+    uint32_t below(uint32_t bound) {
+        return bounded(static_cast<uint32_t>(next() >> 32), bound);
+    }
+
+    // Uniform integer in [low, high]
+    int uniformInt(int low, int high) {
+        return low + static_cast<int>(below(static_cast<uint32_t>(high - low) + 1));
+    }
+
+    // Fills out[0..count) with uniform integers in [low, high]. Every 64-bit
+    // draw feeds two values, so a batch costs half the generator calls.
+    template <typename T>
+    void fillUniformInt(T* out, size_t count, int low, int high) {
+        uint32_t bound = static_cast<uint32_t>(high - low) + 1;
+        size_t i = 0;
+        for (; i + 1 < count; i += 2) {
+            uint64_t bits = next();
+            out[i] = static_cast<T>(low + static_cast<int>(bounded(static_cast<uint32_t>(bits >> 32), bound)));
+            out[i + 1] = static_cast<T>(low + static_cast<int>(bounded(static_cast<uint32_t>(bits), bound)));
+        }
+        if (i < count) {
+            out[i] = static_cast<T>(uniformInt(low, high));
+        }
+    }
+
+    // Fisher-Yates shuffle of a random-access range
+    template <typename Iterator>
+    void shuffle(Iterator first, Iterator last) {
+        auto count = std::distance(first, last);
+        for (auto i = count - 1; i > 0; --i) {
+            auto j = below(static_cast<uint32_t>(i) + 1);
+            std::swap(first[i], first[j]);
+        }
+    }
+};
+
+namespace rng_detail {
+
+inline std::atomic<uint64_t>& masterSeed() {
+    static std::atomic<uint64_t> seed{std::random_device{}() | (uint64_t{std::random_device{}()} << 32)};
+    return seed;
+}
+
+inline std::atomic<uint64_t>& nextStream() {
+    static std::atomic<uint64_t> stream{0};
+    return stream;
+}
+
+struct ThreadRng {
+    Xoshiro256 generator;
+    ThreadRng() : generator(masterSeed().load(), nextStream().fetch_add(1)) {}
+};
+
+inline Xoshiro256& threadGenerator() {
+    thread_local ThreadRng rng;
+    return rng.generator;
+}
+
+}  // namespace rng_detail
+
+// Sets the seed every stream derives from. Call it before any thread draws;
+// without it the master seed comes from std::random_device.
+inline void setMasterSeed(uint64_t seed) {
+    rng_detail::masterSeed().store(seed);
+    rng_detail::nextStream().store(0);
+    rng_detail::threadGenerator().seed(seed, rng_detail::nextStream().fetch_add(1));
+}
+
+inline uint64_t masterSeed() {
+    return rng_detail::masterSeed().load();
+}
+
+// This thread's generator. Threads that never called seedThreadRng() get
+// streams in the order they first draw.
+inline Xoshiro256& threadRng() {
+    return rng_detail::threadGenerator();
+}
+
+// Pins this thread (or freshly forked process) to a fixed stream
+inline void seedThreadRng(uint64_t stream) {
+    rng_detail::threadGenerator().seed(masterSeed(), stream);
+}
@@ -0,0 +1,365 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <queue>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Stacks come from mmap and the x86-64 switch is ELF assembly, so fibers are
+// only built on Linux; FIBER_HAVE_SCHEDULER tells users whether they exist
+#ifdef __linux__
+    #define FIBER_HAVE_SCHEDULER 1
+    #include <unistd.h>
+    #include <sys/mman.h>
+
+// Stackful fibers multiplexed onto a few OS threads (M:N). Each fiber gets a
+// small mmap'ed stack whose pages are only committed when touched, so a
+// sleeping fiber costs a few kilobytes instead of a kernel thread. Switching
+// between fibers saves the callee-saved registers and swaps stack pointers in
+// user space; on x86-64 this is a dozen instructions, elsewhere ucontext is
+// used (slower, since swapcontext also saves the signal mask).
+
+#if defined(__x86_64__) && !defined(FIBER_USE_UCONTEXT)
+#define FIBER_ASM_SWITCH 1
+
+// lab1_fiber_switch(void** saveSp, void* nextSp): pushes the callee-saved
+// registers and the SSE/x87 control words, stores rsp into *saveSp, then
+// loads nextSp and pops the same frame. Weak so several translation units may
+// include this header.
+asm(R"(
+    .text
+    .weak lab1_fiber_switch
+    .type lab1_fiber_switch, @function
+lab1_fiber_switch:
+    pushq %rbp
+    pushq %rbx
+    pushq %r12
+    pushq %r13
+    pushq %r14
+    pushq %r15
+    subq $8, %rsp
+    stmxcsr (%rsp)
+    fnstcw 4(%rsp)
+    movq %rsp, (%rdi)
+    movq %rsi, %rsp
+    ldmxcsr (%rsp)
+    fldcw 4(%rsp)
+    addq $8, %rsp
+    popq %r15
+    popq %r14
+    popq %r13
+    popq %r12
+    popq %rbx
+    popq %rbp
+    ret
+    .size lab1_fiber_switch, .-lab1_fiber_switch
+)");
+
+extern "C" void lab1_fiber_switch(void** saveSp, void* nextSp);
+
+struct FiberContext {
+    void* sp = nullptr;
+};
+
+// Lays out a frame that lab1_fiber_switch pops into a call of entry()
+inline void prepareFiberContext(FiberContext& context, char* stackBase, size_t stackSize,
+                                void (*entry)()) {
+    auto* sp = reinterpret_cast<uint64_t*>(stackBase + stackSize);
+    *--sp = 0;                                         // entry's return address
+    *--sp = reinterpret_cast<uint64_t>(entry);         // target of ret
+    for (int i = 0; i < 6; ++i) {
+        *--sp = 0;                                     // rbp, rbx, r12-r15
+    }
+    *--sp = (uint64_t{0x037F} << 32) | 0x1F80;         // default x87 / MXCSR words
+    context.sp = sp;
+}
+
+inline void switchFiberContext(FiberContext& from, FiberContext& to) {
+    lab1_fiber_switch(&from.sp, to.sp);
+}
+
+#else
+#include <ucontext.h>
+
+struct FiberContext {
+    ucontext_t context;
+};
+
+inline void prepareFiberContext(FiberContext& context, char* stackBase, size_t stackSize,
+                                void (*entry)()) {
+    getcontext(&context.context);
+    context.context.uc_stack.ss_sp = stackBase;
+    context.context.uc_stack.ss_size = stackSize;
+    context.context.uc_link = nullptr;
+    makecontext(&context.context, entry, 0);
+}
+
+inline void switchFiberContext(FiberContext& from, FiberContext& to) {
+    swapcontext(&from.context, &to.context);
+}
+#endif
+
+class FiberScheduler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr size_t DEFAULT_STACK_SIZE = 64 * 1024;
+    static constexpr size_t STACKS_PER_CHUNK = 64;
+
+    struct Stats {
+        uint64_t fibers = 0;
+        uint64_t switches = 0;           // scheduler -> fiber resumes
+        uint64_t peakLive = 0;           // sum of each worker's peak
+        uint64_t stacksMapped = 0;
+        uint64_t unguardedStacks = 0;    // guard page could not be installed
+        size_t stackSize = 0;
+    };
+
+private:
+    struct Worker;
+
+    struct Fiber {
+        std::function<void()> body;
+        FiberContext context;
+        char* stack = nullptr;
+        Worker* worker = nullptr;
+        bool done = false;
+    };
+
+    using Sleeper = std::pair<Clock::time_point, Fiber*>;
+
+    struct Worker {
+        FiberContext scheduler;
+        Fiber* current = nullptr;
+        std::deque<Fiber*> ready;
+        std::priority_queue<Sleeper, std::vector<Sleeper>, std::greater<Sleeper>> sleepers;
+        std::vector<char*> freeStacks;
+        std::vector<std::pair<void*, size_t>> chunks;
+        uint64_t live = 0;
+        uint64_t peakLive = 0;
+        Stats stats;
+    };
+
+    inline static thread_local Worker* currentWorker_ = nullptr;
+
+    std::vector<Worker> workers_;
+    size_t nextWorker_ = 0;
+    size_t stackSize_;
+    size_t pageSize_;
+    std::atomic<long> guardBudget_;
+
+    // Every guard page splits a mapping in two and the kernel caps the number
+    // of mappings per process (vm.max_map_count), so only a quarter of that
+    // limit is spent on guards; later stacks rely on checkCanary alone
+    static long initialGuardBudget() {
+        long maxMapCount = 65530;
+        std::ifstream("/proc/sys/vm/max_map_count") >> maxMapCount;
+        return maxMapCount / 4;
+    }
+
+    char* allocateStack(Worker& worker) {
+        if (worker.freeStacks.empty()) {
+            size_t slotSize = stackSize_ + pageSize_;
+            size_t chunkSize = slotSize * STACKS_PER_CHUNK;
+            void* memory = mmap(nullptr, chunkSize, PROT_READ | PROT_WRITE,
+                                MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+            if (memory == MAP_FAILED) {
+                throw std::runtime_error("cannot map fiber stacks");
+            }
+            worker.chunks.emplace_back(memory, chunkSize);
+            worker.stats.stacksMapped += STACKS_PER_CHUNK;
+
+            char* chunk = static_cast<char*>(memory);
+            for (size_t i = STACKS_PER_CHUNK; i-- > 0;) {
+                char* slot = chunk + i * slotSize;
+                if (guardBudget_.fetch_sub(1, std::memory_order_relaxed) <= 0 ||
+                    mprotect(slot, pageSize_, PROT_NONE) != 0) {
+                    ++worker.stats.unguardedStacks;
+                }
+                worker.freeStacks.push_back(slot + pageSize_);
+            }
+        }
+
+        char* stack = worker.freeStacks.back();
+        worker.freeStacks.pop_back();
+        return stack;
+    }
+
+    // The lowest word of a stack stays zero unless the fiber overflowed into
+    // it. Checked on every switch out; reading it does not commit the page.
+    static void checkCanary(const Fiber& fiber) {
+        if (*reinterpret_cast<const uint64_t*>(fiber.stack) != 0) {
+            std::fputs("fiber stack overflow; raise the stack size\n", stderr);
+            std::abort();
+        }
+    }
+
+    static void fiberEntry() noexcept {
+        Worker* worker = currentWorker_;
+        Fiber* fiber = worker->current;
+        fiber->body();
+        fiber->done = true;
+        switchFiberContext(fiber->context, fiber->worker->scheduler);
+    }
+
+    // Parks the running fiber and returns to its worker's scheduler loop
+    static void suspend(Fiber& fiber) {
+        switchFiberContext(fiber.context, fiber.worker->scheduler);
+    }
+
+    void enqueue(Worker& worker, Fiber* fiber) {
+        fiber->worker = &worker;
+        worker.ready.push_back(fiber);
+        ++worker.stats.fibers;
+        worker.peakLive = std::max(worker.peakLive, ++worker.live);
+    }
+
+    void runWorker(Worker& worker) {
+        currentWorker_ = &worker;
+
+        while (true) {
+            if (!worker.sleepers.empty()) {
+                auto now = Clock::now();
+                while (!worker.sleepers.empty() && worker.sleepers.top().first <= now) {
+                    worker.ready.push_back(worker.sleepers.top().second);
+                    worker.sleepers.pop();
+                }
+            }
+
+            if (!worker.ready.empty()) {
+                Fiber* fiber = worker.ready.front();
+                worker.ready.pop_front();
+                if (fiber->stack == nullptr) {
+                    fiber->stack = allocateStack(worker);
+                    prepareFiberContext(fiber->context, fiber->stack, stackSize_, &fiberEntry);
+                }
+
+                worker.current = fiber;
+                ++worker.stats.switches;
+                switchFiberContext(worker.scheduler, fiber->context);
+                worker.current = nullptr;
+                checkCanary(*fiber);
+
+                if (fiber->done) {
+                    worker.freeStacks.push_back(fiber->stack);
+                    delete fiber;
+                    --worker.live;
+                }
+                continue;
+            }
+
+            if (!worker.sleepers.empty()) {
+                std::this_thread::sleep_until(worker.sleepers.top().first);
+                continue;
+            }
+            break;
+        }
+
+        currentWorker_ = nullptr;
+    }
+
+public:
+    explicit FiberScheduler(size_t threads, size_t stackSize = DEFAULT_STACK_SIZE)
+        : workers_(std::max<size_t>(1, threads)), guardBudget_(initialGuardBudget()) {
+        pageSize_ = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        stackSize_ = std::max(stackSize, 2 * pageSize_);
+        stackSize_ = (stackSize_ + pageSize_ - 1) / pageSize_ * pageSize_;
+    }
+
+    FiberScheduler(const FiberScheduler&) = delete;
+    FiberScheduler& operator=(const FiberScheduler&) = delete;
+
+    ~FiberScheduler() {
+        for (auto& worker : workers_) {
+            for (Fiber* fiber : worker.ready) {
+                delete fiber;
+            }
+            for (auto& chunk : worker.chunks) {
+                munmap(chunk.first, chunk.second);
+            }
+        }
+    }
+
+    // Adds a fiber. Before run() fibers are spread round-robin over the
+    // workers; from inside a fiber the new one joins the caller's worker.
+    void spawn(std::function<void()> body) {
+        Fiber* fiber = new Fiber();
+        fiber->body = std::move(body);
+        if (currentWorker_ != nullptr) {
+            enqueue(*currentWorker_, fiber);
+        } else {
+            enqueue(workers_[nextWorker_], fiber);
+            nextWorker_ = (nextWorker_ + 1) % workers_.size();
+        }
+    }
+
+    // Runs every fiber to completion on one OS thread per worker
+    void run() {
+        std::vector<std::thread> threads;
+        for (size_t i = 1; i < workers_.size(); ++i) {
+            threads.emplace_back(&FiberScheduler::runWorker, this, std::ref(workers_[i]));
+        }
+        runWorker(workers_[0]);
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
+
+    Stats stats() const {
+        Stats total;
+        total.stackSize = stackSize_;
+        for (const auto& worker : workers_) {
+            total.fibers += worker.stats.fibers;
+            total.switches += worker.stats.switches;
+            total.peakLive += worker.peakLive;
+            total.stacksMapped += worker.stats.stacksMapped;
+            total.unguardedStacks += worker.stats.unguardedStacks;
+        }
+        return total;
+    }
+
+    static bool inFiber() {
+        return currentWorker_ != nullptr && currentWorker_->current != nullptr;
+    }
+
+    // Lets the other ready fibers of this worker run first
+    static void yield() {
+        if (!inFiber()) {
+            std::this_thread::yield();
+            return;
+        }
+        Fiber* fiber = currentWorker_->current;
+        fiber->worker->ready.push_back(fiber);
+        suspend(*fiber);
+    }
+
+    // Parks the fiber until the deadline without blocking its OS thread;
+    // outside a fiber this is an ordinary thread sleep
+    static void sleepUntil(Clock::time_point deadline) {
+        if (!inFiber()) {
+            std::this_thread::sleep_until(deadline);
+            return;
+        }
+        Fiber* fiber = currentWorker_->current;
+        fiber->worker->sleepers.emplace(deadline, fiber);
+        suspend(*fiber);
+    }
+
+    template <typename Rep, typename Period>
+    static void sleepFor(std::chrono::duration<Rep, Period> duration) {
+        sleepUntil(Clock::now() + std::chrono::duration_cast<Clock::duration>(duration));
+    }
+};
+
+#endif
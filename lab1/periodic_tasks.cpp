@@ -0,0 +1,117 @@
+#include <iostream>
+#include <string>
+#include <chrono>
+#include "timer_wheel.h"
+#include "../common/memory_usage.h"
+#include "../common/rng.h"
+#include "../common/async_logger.h"
+
+using std::cerr;
+using std::cout;
+using std::string;
+
+constexpr int MIN_DELAY_MS = 100;
+constexpr int MAX_DELAY_MS = 1000;
+constexpr int MIN_REPETITIONS = 5;
+constexpr int MAX_REPETITIONS = 20;
+
+// Command line configuration
+struct Options {
+    int threads = 2;
+    int tasks = 0;
+    bool quiet = false;
+    bool seeded = false;
+    uint64_t seed = 0;
+};
+
+// One firing of a periodic greeting: the body of printGreeting's loop
+void printGreeting(const string& message) {
+    AsyncLogger::instance().log("{}", message);
+}
+
+void printUsage(const char* program) {
+    cerr << "Usage: " << program << " [--threads N] [--tasks N] [--seed S] [--quiet]\n"
+         << "  Without --tasks the three greetings from simple_threads are run.\n";
+}
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (arg == "--threads" && hasValue) {
+            options.threads = std::stoi(argv[++i]);
+        } else if (arg == "--tasks" && hasValue) {
+            options.tasks = std::stoi(argv[++i]);
+        } else if (arg == "--seed" && hasValue) {
+            options.seed = std::stoull(argv[++i]);
+            options.seeded = true;
+        } else if (arg == "--quiet") {
+            options.quiet = true;
+        } else {
+            return false;
+        }
+    }
+    return options.threads > 0 && options.tasks >= 0;
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    try {
+        if (!parseOptions(argc, argv, options)) {
+            printUsage(argv[0]);
+            return 1;
+        }
+    } catch (const std::exception&) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    if (options.seeded) {
+        setMasterSeed(options.seed);
+    }
+    PeriodicScheduler scheduler(options.threads);
+    auto every = [](int ms) { return std::chrono::milliseconds(ms); };
+
+    if (options.tasks == 0) {
+        // Same messages, delays and repetition counts as simple_threads
+        scheduler.schedule(every(100), 10, []() { printGreeting("I am A"); });
+        scheduler.schedule(every(150), 15, []() { printGreeting("\tI am B"); });
+        scheduler.schedule(every(300), 5, []() { printGreeting("\t\tI am C"); });
+    } else {
+        Xoshiro256& generator = threadRng();
+
+        for (int i = 0; i < options.tasks; ++i) {
+            string message = "I am task " + std::to_string(i + 1);
+            bool quiet = options.quiet;
+            scheduler.schedule(every(generator.uniformInt(MIN_DELAY_MS, MAX_DELAY_MS)),
+                               generator.uniformInt(MIN_REPETITIONS, MAX_REPETITIONS),
+                               [message, quiet]() {
+                                   if (!quiet) {
+                                       printGreeting(message);
+                                   }
+                               });
+        }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    PeriodicScheduler::Stats stats = scheduler.run();
+    double elapsedMs = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+    AsyncLogger::instance().flush();
+
+    if (options.tasks > 0) {
+        const LatencyHistogram& lateness = stats.lateness;
+        MemoryUsage memory = readMemoryUsage();
+        cout << "Tasks: " << options.tasks << " on " << options.threads << " threads, "
+             << stats.firings << " firings in " << elapsedMs << " ms\n"
+             << "Lateness (us): p50 " << lateness.percentile(50) / 1000.0
+             << ", p99 " << lateness.percentile(99) / 1000.0
+             << ", p99.9 " << lateness.percentile(99.9) / 1000.0
+             << ", max " << lateness.max() / 1000.0 << "\n"
+             << "Peak RSS: " << memory.peakRssKb << " KB\n";
+    }
+
+    cout << "End\n";
+    return 0;
+}
@@ -2,15 +2,25 @@
 #include <thread>
 #include <string>
 #include <chrono>
-#include <random>
-#include <array>
+#include <vector>
+#include <future>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include "thread_pool.h"
+#include "work_stealing_scheduler.h"
+#include "../common/memory_usage.h"
+#include "../common/rng.h"
+#include "../common/affinity.h"
+#include "../common/async_logger.h"
 
-using std::array;
+using std::atomic;
+using std::cerr;
 using std::cout;
-using std::mt19937;
-using std::random_device;
+using std::future;
+using std::string;
 using std::thread;
-using std::uniform_int_distribution;
+using std::vector;
 
 constexpr int THREAD_COUNT = 15;
 constexpr int MIN_DELAY_MS = 100;
@@ -18,33 +28,232 @@ constexpr int MAX_DELAY_MS = 1000;
 constexpr int MIN_REPETITIONS = 5;
 constexpr int MAX_REPETITIONS = 20;
 
+// Busy-loop iterations standing in for each millisecond of delay in the
+// CPU-bound workload, which keeps the full job mix to a fraction of a second
+constexpr int CPU_WORK_PER_DELAY_MS = 1000;
+
+// Command line configuration
+struct Options {
+    string executor = "thread";
+    string workload = "sleep";
+    int jobs = THREAD_COUNT;
+    int minWorkers = 0;
+    int maxWorkers = static_cast<int>(std::max(1u, thread::hardware_concurrency()));
+    bool noDelay = false;
+    bool quiet = false;
+    bool stats = false;
+    bool logBinary = false;
+    bool logDrop = false;
+    bool seeded = false;
+    uint64_t seed = 0;
+    ThreadPlacement placement;
+};
+
+bool printMessages = true;
+
+// Total time spent inside jobs, used to estimate the ideal parallel runtime
+atomic<int64_t> busyNanoseconds{0};
+
+// Keeps the CPU-bound loop from being optimized away
+atomic<uint64_t> workChecksum{0};
+
 // Prints a thread identification message multiple times with a delay
 void printThreadMessage(int threadId, int delayMs, int repetitions) {
     for (int i = 0; i < repetitions; ++i) {
-        cout << "I am thread " << threadId << "\n";
+        if (printMessages) {
+            AsyncLogger::instance().log("I am thread {}", threadId);
+        }
         std::this_thread::sleep_for(std::chrono::milliseconds(delayMs));
     }
 }
 
-int main() {
-    array<thread, THREAD_COUNT> threads;
+// CPU-bound variant of printThreadMessage: computes instead of sleeping
+void computeThreadMessage(int threadId, int delayMs, int repetitions) {
+    uint64_t state = static_cast<uint64_t>(threadId);
+    for (int i = 0; i < repetitions; ++i) {
+        if (printMessages) {
+            AsyncLogger::instance().log("I am thread {}", threadId);
+        }
+        for (int step = 0; step < delayMs * CPU_WORK_PER_DELAY_MS; ++step) {
+            state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        }
+    }
+    workChecksum.fetch_add(state, std::memory_order_relaxed);
+}
+
+// Runs one job with the selected workload and records how long it took
+void runJob(bool cpuBound, int threadId, int delayMs, int repetitions) {
+    auto start = std::chrono::steady_clock::now();
+    if (cpuBound) {
+        computeThreadMessage(threadId, delayMs, repetitions);
+    } else {
+        printThreadMessage(threadId, delayMs, repetitions);
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    busyNanoseconds.fetch_add(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count(),
+        std::memory_order_relaxed);
+}
+
+void printUsage(const char* program) {
+    cerr << "Usage: " << program << " [--executor thread|pool|steal] [--workload sleep|cpu]\n"
+         << "       [--jobs N] [--min-workers N] [--max-workers N]\n"
+         << "       [--no-delay] [--quiet] [--stats] [--log-binary] [--log-drop]\n"
+         << "       [--seed S] [--placement none|compact|scatter|node[:N]]\n"
+         << "  --max-workers is the pool ceiling and the work-stealing worker count\n";
+}
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (arg == "--executor" && hasValue) {
+            options.executor = argv[++i];
+        } else if (arg == "--workload" && hasValue) {
+            options.workload = argv[++i];
+        } else if (arg == "--jobs" && hasValue) {
+            options.jobs = std::stoi(argv[++i]);
+        } else if (arg == "--min-workers" && hasValue) {
+            options.minWorkers = std::stoi(argv[++i]);
+        } else if (arg == "--max-workers" && hasValue) {
+            options.maxWorkers = std::stoi(argv[++i]);
+        } else if (arg == "--no-delay") {
+            options.noDelay = true;
+        } else if (arg == "--seed" && hasValue) {
+            options.seed = std::stoull(argv[++i]);
+            options.seeded = true;
+        } else if (arg == "--placement" && hasValue) {
+            options.placement = ThreadPlacement::parse(argv[++i]);
+        } else if (arg == "--quiet") {
+            options.quiet = true;
+        } else if (arg == "--stats") {
+            options.stats = true;
+        } else if (arg == "--log-binary") {
+            options.logBinary = true;
+        } else if (arg == "--log-drop") {
+            options.logDrop = true;
+        } else {
+            return false;
+        }
+    }
+    return (options.executor == "thread" || options.executor == "pool" ||
+            options.executor == "steal") &&
+           (options.workload == "sleep" || options.workload == "cpu") &&
+           options.jobs > 0 && options.minWorkers >= 0 && options.maxWorkers > 0;
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    try {
+        if (!parseOptions(argc, argv, options)) {
+            printUsage(argv[0]);
+            return 1;
+        }
+    } catch (const std::exception&) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    printMessages = !options.quiet;
+    AsyncLogger& logger = AsyncLogger::instance();
+    logger.setBinary(options.logBinary);
+    logger.setDropWhenFull(options.logDrop);
 
     // Random number generation setup
-    random_device randomDevice;
-    mt19937 generator(randomDevice());
-    uniform_int_distribution<> delayDistribution(MIN_DELAY_MS, MAX_DELAY_MS);
-    uniform_int_distribution<> repetitionDistribution(MIN_REPETITIONS, MAX_REPETITIONS);
+    if (options.seeded) {
+        setMasterSeed(options.seed);
+    }
+    Xoshiro256& generator = threadRng();
+
+    bool cpuBound = options.workload == "cpu";
+    size_t threadsCreated = 0;
+    size_t workers = 0;
+    WorkStealingScheduler::Stats stealStats;
+    auto start = std::chrono::steady_clock::now();
 
-    // Create and launch threads with random parameters
-    for (int i = 0; i < THREAD_COUNT; ++i) {
-        int delay = delayDistribution(generator);
-        int repetitions = repetitionDistribution(generator);
-        threads[i] = thread(&printThreadMessage, i + 1, delay, repetitions);
+    if (options.executor == "thread") {
+        vector<thread> threads;
+        threads.reserve(options.jobs);
+
+        // Create and launch one thread per job with random parameters
+        for (int i = 0; i < options.jobs; ++i) {
+            int delay = options.noDelay ? 0 : generator.uniformInt(MIN_DELAY_MS, MAX_DELAY_MS);
+            int repetitions = generator.uniformInt(MIN_REPETITIONS, MAX_REPETITIONS);
+            threads.emplace_back(&runJob, cpuBound, i + 1, delay, repetitions);
+            options.placement.pinThread(threads.back(), i);
+        }
+        threadsCreated = threads.size();
+        workers = threads.size();
+
+        // Wait for all threads to complete
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    } else if (options.executor == "pool") {
+        const ThreadPlacement& placement = options.placement;
+        ThreadPool pool(options.minWorkers, options.maxWorkers, std::chrono::milliseconds(100),
+                        [&placement](size_t index) { placement.pinCurrentThread(index); });
+        vector<future<void>> results;
+        results.reserve(options.jobs);
+
+        // Queue every job on the shared pool
+        for (int i = 0; i < options.jobs; ++i) {
+            int delay = options.noDelay ? 0 : generator.uniformInt(MIN_DELAY_MS, MAX_DELAY_MS);
+            int repetitions = generator.uniformInt(MIN_REPETITIONS, MAX_REPETITIONS);
+            results.push_back(pool.submit(&runJob, cpuBound, i + 1, delay, repetitions));
+        }
+
+        // Wait for all jobs to complete
+        for (auto& result : results) {
+            result.get();
+        }
+        threadsCreated = pool.threadsCreated();
+        workers = pool.peakWorkers();
+    } else {
+        const ThreadPlacement& placement = options.placement;
+        WorkStealingScheduler scheduler(options.maxWorkers,
+                                        [&placement](size_t index) { placement.pinCurrentThread(index); });
+
+        // Jobs are dealt round-robin onto the per-worker deques
+        for (int i = 0; i < options.jobs; ++i) {
+            int delay = options.noDelay ? 0 : generator.uniformInt(MIN_DELAY_MS, MAX_DELAY_MS);
+            int repetitions = generator.uniformInt(MIN_REPETITIONS, MAX_REPETITIONS);
+            scheduler.submit([=]() { runJob(cpuBound, i + 1, delay, repetitions); });
+        }
+
+        // Wait for all jobs to complete
+        scheduler.wait();
+        threadsCreated = scheduler.workerCount();
+        workers = scheduler.workerCount();
+        stealStats = scheduler.stats();
     }
 
-    // Wait for all threads to complete
-    for (auto& thread : threads) {
-        thread.join();
+    auto elapsed = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start);
+    logger.flush();
+
+    if (options.stats) {
+        MemoryUsage memory = readMemoryUsage();
+        // Ideal linear speedup would finish the total job time in busy / workers
+        double busyMs = busyNanoseconds.load() / 1e6;
+        double idealMs = busyMs / std::max<size_t>(1, workers);
+        cout << "Executor: " << options.executor << ", workload: " << options.workload
+             << ", jobs: " << options.jobs << ", workers: " << workers << "\n"
+             << "Placement: " << options.placement.describe(workers) << "\n"
+             << "Elapsed: " << elapsed.count() << " ms (ideal " << idealMs
+             << " ms, " << 100.0 * idealMs / elapsed.count() << "% of linear speedup)\n"
+             << "OS threads created: " << threadsCreated << "\n"
+             << "Peak RSS: " << memory.peakRssKb << " KB, peak virtual: "
+             << memory.peakVirtualKb << " KB\n";
+        if (options.executor == "steal") {
+            cout << "Tasks run locally: " << stealStats.localTasks
+                 << ", stolen: " << stealStats.stolenTasks
+                 << ", failed steal attempts: " << stealStats.failedSteals << "\n";
+        }
+        AsyncLogger::Stats logStats = logger.stats();
+        cout << "Logger: " << logStats.lines << " lines, " << logStats.dropped << " dropped, "
+             << "max queue depth " << logStats.maxQueueDepth << ", "
+             << logStats.writeCalls << " write() calls\n";
     }
 
     cout << "End\n";
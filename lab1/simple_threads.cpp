@@ -2,6 +2,7 @@
 #include <thread>
 #include <string>
 #include <chrono>
+#include "../common/async_logger.h"
 
 using std::cout;
 using std::string;
@@ -10,7 +11,7 @@ using std::thread;
 // Prints a greeting message multiple times with a delay between each print
 void printGreeting(const string& message, int delayMs, int repetitions) {
     for (int i = 0; i < repetitions; ++i) {
-        cout << message << "\n";
+        AsyncLogger::instance().log("{}", message);
         std::this_thread::sleep_for(std::chrono::milliseconds(delayMs));
     }
 }
@@ -26,6 +27,7 @@ int main() {
     thread2.join();
     thread3.join();
     
+    AsyncLogger::instance().flush();
     cout << "End\n";
     return 0;
 }
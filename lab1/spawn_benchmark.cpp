@@ -0,0 +1,217 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <sstream>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <system_error>
+#include "thread_spawner.h"
+#include "../common/latency_histogram.h"
+#include "../common/memory_usage.h"
+#include "../common/futex.h"
+
+using std::atomic;
+using std::cerr;
+using std::cout;
+using std::setw;
+using std::string;
+using std::vector;
+
+// How far can thread-per-connection go? For each thread count this starts
+// that many threads, keeps them all alive at once, and reports:
+//   create -> first run   time from asking for a thread to its body running
+//   join                  cost of join() on a thread that has already
+//                         finished its body (reaping it and its stack)
+//   RSS / virtual         memory growth per live thread
+// Spawning stops at the first thread the OS refuses, and the limit is shown.
+
+constexpr int DEFAULT_STACK_KB = 64;
+constexpr int DEFAULT_GUARD_KB = 4;
+
+struct Options {
+    vector<long> counts{10, 100, 1000, 10000, 100000};
+    vector<SpawnConfig::Api> apis{SpawnConfig::Api::Pthread};
+    size_t stackKb = DEFAULT_STACK_KB;
+    size_t guardKb = DEFAULT_GUARD_KB;
+};
+
+struct SpawnResult {
+    long requested = 0;
+    long spawned = 0;
+    string failure;  // why spawning stopped early, empty if it did not
+    double spawnSeconds = 0;
+    LatencyHistogram firstRun;
+    LatencyHistogram join;
+    double rssKbPerThread = 0;
+    double virtualKbPerThread = 0;
+};
+
+uint64_t nowNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+SpawnResult runSpawn(const ThreadSpawner& spawner, long count) {
+    SpawnResult result;
+    result.requested = count;
+
+    vector<uint64_t> createdNs(count);
+    vector<uint64_t> firstRunNs(count);
+    vector<SpawnedThread> threads;
+    threads.reserve(count);
+    atomic<long> started{0};
+    atomic<long> finished{0};
+    atomic<uint32_t> release{0};
+
+    MemoryUsage baseline = readMemoryUsage();
+    uint64_t spawnStart = nowNs();
+    for (long i = 0; i < count; ++i) {
+        createdNs[i] = nowNs();
+        try {
+            threads.push_back(spawner.spawn([&, i]() {
+                firstRunNs[i] = nowNs();
+                started.fetch_add(1);
+                while (release.load() == 0) {
+                    futexWait(&release, 0, false);
+                }
+                finished.fetch_add(1);
+            }));
+        } catch (const std::system_error& e) {
+            result.failure = e.code().message();
+            break;
+        }
+    }
+    result.spawned = static_cast<long>(threads.size());
+    result.spawnSeconds = (nowNs() - spawnStart) / 1e9;
+
+    // Every thread must be running (and parked) before memory is sampled
+    while (started.load() < result.spawned) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    MemoryUsage loaded = readMemoryUsage();
+    if (result.spawned > 0) {
+        result.rssKbPerThread = static_cast<double>(loaded.rssKb - baseline.rssKb) / result.spawned;
+        result.virtualKbPerThread =
+            static_cast<double>(loaded.virtualKb - baseline.virtualKb) / result.spawned;
+    }
+
+    release.store(1);
+    futexWakeAll(&release, false);
+    while (finished.load() < result.spawned) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    for (long i = 0; i < result.spawned; ++i) {
+        uint64_t joinStart = nowNs();
+        threads[i].join();
+        result.join.record(nowNs() - joinStart);
+        result.firstRun.record(firstRunNs[i] - createdNs[i]);
+    }
+    return result;
+}
+
+void printHeader() {
+    cout << " threads | spawned |  threads/s | first run p50/p99 us |  join p50/p99 us"
+         << " | RSS KB/thr | virt KB/thr\n";
+}
+
+void printResult(const SpawnResult& result) {
+    auto micros = [](uint64_t ns) { return ns / 1000.0; };
+    std::ostringstream firstRun;
+    std::ostringstream join;
+    firstRun << std::fixed << std::setprecision(1) << micros(result.firstRun.percentile(50)) << " / "
+             << micros(result.firstRun.percentile(99));
+    join << std::fixed << std::setprecision(1) << micros(result.join.percentile(50)) << " / "
+         << micros(result.join.percentile(99));
+
+    cout << setw(8) << result.requested << " | " << setw(7) << result.spawned << " | " << setw(10)
+         << std::fixed << std::setprecision(0)
+         << (result.spawnSeconds > 0 ? result.spawned / result.spawnSeconds : 0) << " | "
+         << setw(20) << firstRun.str() << " | " << setw(16) << join.str() << " | " << setw(10)
+         << std::setprecision(1) << result.rssKbPerThread << " | " << setw(11)
+         << result.virtualKbPerThread << "\n";
+    if (!result.failure.empty()) {
+        cout << "          limit reached after " << result.spawned << " threads: " << result.failure
+             << "\n";
+    }
+}
+
+void printUsage(const char* program) {
+    cerr << "Usage: " << program << " [--counts LIST] [--api pthread|std|pthread,std]\n"
+         << "       [--stack-kb KB] [--guard-kb KB]\n"
+         << "  --counts defaults to 10,100,1000,10000,100000; --stack-kb 0 keeps the default stack\n";
+}
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (arg == "--counts" && hasValue) {
+            options.counts.clear();
+            std::stringstream list(argv[++i]);
+            string item;
+            while (std::getline(list, item, ',')) {
+                options.counts.push_back(std::stol(item));
+            }
+        } else if (arg == "--api" && hasValue) {
+            options.apis.clear();
+            std::stringstream list(argv[++i]);
+            string item;
+            while (std::getline(list, item, ',')) {
+                if (item == "pthread") {
+                    options.apis.push_back(SpawnConfig::Api::Pthread);
+                } else if (item == "std") {
+                    options.apis.push_back(SpawnConfig::Api::Std);
+                } else {
+                    return false;
+                }
+            }
+        } else if (arg == "--stack-kb" && hasValue) {
+            options.stackKb = std::stoul(argv[++i]);
+        } else if (arg == "--guard-kb" && hasValue) {
+            options.guardKb = std::stoul(argv[++i]);
+        } else {
+            return false;
+        }
+    }
+    for (long count : options.counts) {
+        if (count < 1) {
+            return false;
+        }
+    }
+    return !options.counts.empty() && !options.apis.empty();
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    try {
+        if (!parseOptions(argc, argv, options)) {
+            printUsage(argv[0]);
+            return 1;
+        }
+    } catch (const std::exception&) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    for (SpawnConfig::Api api : options.apis) {
+        SpawnConfig config;
+        config.api = api;
+        config.stackSize = options.stackKb * 1024;
+        config.guardSize = options.guardKb * 1024;
+        ThreadSpawner spawner(config);
+
+        cout << "\n=== " << config.describe() << " ===\n";
+        printHeader();
+        for (long count : options.counts) {
+            SpawnResult result = runSpawn(spawner, count);
+            printResult(result);
+            if (!result.failure.empty()) {
+                break;  // larger counts would hit the same limit
+            }
+        }
+    }
+    return 0;
+}
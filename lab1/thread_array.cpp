@@ -3,6 +3,7 @@
 #include <string>
 #include <chrono>
 #include <array>
+#include "../common/async_logger.h"
 
 using std::array;
 using std::cout;
@@ -12,7 +13,7 @@ using std::thread;
 // Prints a greeting message multiple times with a delay between each print
 void printGreeting(const string& message, int delayMs, int repetitions) {
     for (int i = 0; i < repetitions; ++i) {
-        cout << message << "\n";
+        AsyncLogger::instance().log("{}", message);
         std::this_thread::sleep_for(std::chrono::milliseconds(delayMs));
     }
 }
@@ -31,6 +32,7 @@ int main() {
         thread.join();
     }
     
+    AsyncLogger::instance().flush();
     cout << "End\n";
     return 0;
 }
@@ -2,24 +2,54 @@
 #include <thread>
 #include <string>
 #include <chrono>
-#include <random>
-#include <array>
+#include <vector>
 #include <memory>
+#include <future>
+#include <algorithm>
+#include <mutex>
+#include <condition_variable>
+#include "thread_pool.h"
+#include "fiber.h"
+#include "../common/memory_usage.h"
+#include "../common/rng.h"
+#include "../common/async_logger.h"
 
-using std::array;
+using std::cerr;
+using std::condition_variable;
 using std::cout;
+using std::future;
 using std::make_unique;
-using std::mt19937;
-using std::random_device;
+using std::mutex;
+using std::string;
 using std::thread;
-using std::uniform_int_distribution;
+using std::unique_lock;
 using std::unique_ptr;
+using std::vector;
 
 constexpr int THREAD_COUNT = 15;
 constexpr int MIN_DELAY_MS = 100;
 constexpr int MAX_DELAY_MS = 1000;
 constexpr int MIN_REPETITIONS = 5;
 constexpr int MAX_REPETITIONS = 20;
+constexpr int SWITCH_ROUNDS = 200000;
+
+// Command line configuration
+struct Options {
+    string executor = "thread";
+    int jobs = THREAD_COUNT;
+    int minWorkers = 0;
+    int maxWorkers = static_cast<int>(std::max(1u, thread::hardware_concurrency()));
+#ifdef FIBER_HAVE_SCHEDULER
+    size_t fiberStackKb = FiberScheduler::DEFAULT_STACK_SIZE / 1024;
+#endif
+    bool noDelay = false;
+    bool quiet = false;
+    bool stats = false;
+    bool logBinary = false;
+    bool logDrop = false;
+    bool seeded = false;
+    uint64_t seed = 0;
+};
 
 // Encapsulates the behavior of a thread process
 class ThreadProcess {
@@ -27,41 +57,241 @@ private:
     int id_;
     int delayMs_;
     int repetitions_;
+    bool verbose_;
 
 public:
-    ThreadProcess(int id, int delayMs, int repetitions) 
-        : id_(id), delayMs_(delayMs), repetitions_(repetitions) {}
+    ThreadProcess(int id, int delayMs, int repetitions, bool verbose = true)
+        : id_(id), delayMs_(delayMs), repetitions_(repetitions), verbose_(verbose) {}
 
-    // Executes the thread's main behavior
+    // Executes the thread's main behavior; on a fiber the sleep parks the
+    // fiber instead of its OS thread
     void execute() {
         for (int i = 0; i < repetitions_; ++i) {
-            cout << "I am thread " << id_ << "\n";
+            if (verbose_) {
+                AsyncLogger::instance().log("I am thread {}", id_);
+            }
+#ifdef FIBER_HAVE_SCHEDULER
+            FiberScheduler::sleepFor(std::chrono::milliseconds(delayMs_));
+#else
             std::this_thread::sleep_for(std::chrono::milliseconds(delayMs_));
+#endif
         }
     }
 };
 
-int main() {
-    array<thread, THREAD_COUNT> threads;
-    array<unique_ptr<ThreadProcess>, THREAD_COUNT> processes;
+#ifdef FIBER_HAVE_SCHEDULER
+// Nanoseconds per fiber switch: two fibers on one worker yielding to each other
+double measureFiberSwitchNs() {
+    FiberScheduler scheduler(1);
+    for (int f = 0; f < 2; ++f) {
+        scheduler.spawn([]() {
+            for (int i = 0; i < SWITCH_ROUNDS; ++i) {
+                FiberScheduler::yield();
+            }
+        });
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    scheduler.run();
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    // Each resume is one switch in and one switch back out to the scheduler
+    return elapsed.count() / (2.0 * scheduler.stats().switches);
+}
+#endif
+
+// Nanoseconds per hand-off between two OS threads ping-ponging on a
+// condition variable: the kernel-level equivalent of a fiber switch
+double measureThreadSwitchNs() {
+    mutex turnMutex;
+    condition_variable turnChanged;
+    int turn = 0;
+
+    auto player = [&](int self) {
+        for (int i = 0; i < SWITCH_ROUNDS; ++i) {
+            unique_lock<mutex> lock(turnMutex);
+            turnChanged.wait(lock, [&]() { return turn == self; });
+            turn = 1 - self;
+            turnChanged.notify_one();
+        }
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    thread other(player, 1);
+    player(0);
+    other.join();
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / (2.0 * SWITCH_ROUNDS);
+}
+
+void printUsage(const char* program) {
+    cerr << "Usage: " << program << " [--executor thread|pool|fiber] [--jobs N]\n"
+         << "       [--min-workers N] [--max-workers N] [--fiber-stack KB] [--no-delay]\n"
+         << "       [--quiet] [--stats] [--log-binary] [--log-drop] [--seed S]\n"
+         << "  --max-workers is the pool ceiling and the number of fiber threads\n"
+         << "  --executor fiber and --fiber-stack are only available on Linux\n";
+}
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (arg == "--executor" && hasValue) {
+            options.executor = argv[++i];
+        } else if (arg == "--jobs" && hasValue) {
+            options.jobs = std::stoi(argv[++i]);
+        } else if (arg == "--min-workers" && hasValue) {
+            options.minWorkers = std::stoi(argv[++i]);
+        } else if (arg == "--max-workers" && hasValue) {
+            options.maxWorkers = std::stoi(argv[++i]);
+#ifdef FIBER_HAVE_SCHEDULER
+        } else if (arg == "--fiber-stack" && hasValue) {
+            options.fiberStackKb = std::stoul(argv[++i]);
+#endif
+        } else if (arg == "--no-delay") {
+            options.noDelay = true;
+        } else if (arg == "--seed" && hasValue) {
+            options.seed = std::stoull(argv[++i]);
+            options.seeded = true;
+        } else if (arg == "--quiet") {
+            options.quiet = true;
+        } else if (arg == "--stats") {
+            options.stats = true;
+        } else if (arg == "--log-binary") {
+            options.logBinary = true;
+        } else if (arg == "--log-drop") {
+            options.logDrop = true;
+        } else {
+            return false;
+        }
+    }
+#ifdef FIBER_HAVE_SCHEDULER
+    bool fiber = options.executor == "fiber";
+#else
+    bool fiber = false;  // fibers are only built on Linux
+#endif
+    return (options.executor == "thread" || options.executor == "pool" || fiber) &&
+           options.jobs > 0 && options.minWorkers >= 0 && options.maxWorkers > 0;
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    try {
+        if (!parseOptions(argc, argv, options)) {
+            printUsage(argv[0]);
+            return 1;
+        }
+    } catch (const std::exception&) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    AsyncLogger& logger = AsyncLogger::instance();
+    logger.setBinary(options.logBinary);
+    logger.setDropWhenFull(options.logDrop);
+
+    vector<unique_ptr<ThreadProcess>> processes;
+    processes.reserve(options.jobs);
 
     // Random number generation setup
-    random_device randomDevice;
-    mt19937 generator(randomDevice());
-    uniform_int_distribution<> delayDistribution(MIN_DELAY_MS, MAX_DELAY_MS);
-    uniform_int_distribution<> repetitionDistribution(MIN_REPETITIONS, MAX_REPETITIONS);
-
-    // Create and launch threads with random parameters
-    for (int i = 0; i < THREAD_COUNT; ++i) {
-        int delay = delayDistribution(generator);
-        int repetitions = repetitionDistribution(generator);
-        processes[i] = std::make_unique<ThreadProcess>(i + 1, delay, repetitions);
-        threads[i] = thread(&ThreadProcess::execute, processes[i].get());
+    if (options.seeded) {
+        setMasterSeed(options.seed);
+    }
+    vector<int> delays(options.jobs, 0);
+    vector<int> repetitions(options.jobs);
+    if (!options.noDelay) {
+        threadRng().fillUniformInt(delays.data(), delays.size(), MIN_DELAY_MS, MAX_DELAY_MS);
+    }
+    threadRng().fillUniformInt(repetitions.data(), repetitions.size(), MIN_REPETITIONS, MAX_REPETITIONS);
+
+    // Create the processes with random parameters
+    for (int i = 0; i < options.jobs; ++i) {
+        processes.push_back(make_unique<ThreadProcess>(i + 1, delays[i], repetitions[i], !options.quiet));
     }
 
-    // Wait for all threads to complete
-    for (auto& thread : threads) {
-        thread.join();
+    size_t threadsCreated = 0;
+#ifdef FIBER_HAVE_SCHEDULER
+    FiberScheduler::Stats fiberStats;
+#endif
+    MemoryUsage baseline = readMemoryUsage();
+    auto start = std::chrono::steady_clock::now();
+
+    if (options.executor == "thread") {
+        vector<thread> threads;
+        threads.reserve(options.jobs);
+
+        // Launch one thread per process
+        for (auto& process : processes) {
+            threads.emplace_back(&ThreadProcess::execute, process.get());
+        }
+        threadsCreated = threads.size();
+
+        // Wait for all threads to complete
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    } else if (options.executor == "pool") {
+        ThreadPool pool(options.minWorkers, options.maxWorkers);
+        vector<future<void>> results;
+        results.reserve(options.jobs);
+
+        // Queue every process on the shared pool
+        for (auto& process : processes) {
+            results.push_back(pool.submit(&ThreadProcess::execute, process.get()));
+        }
+
+        // Wait for all processes to complete
+        for (auto& result : results) {
+            result.get();
+        }
+        threadsCreated = pool.threadsCreated();
+    } else {
+#ifdef FIBER_HAVE_SCHEDULER
+        FiberScheduler scheduler(options.maxWorkers, options.fiberStackKb * 1024);
+
+        // One fiber per process, multiplexed onto maxWorkers OS threads
+        for (auto& process : processes) {
+            ThreadProcess* target = process.get();
+            scheduler.spawn([target]() { target->execute(); });
+        }
+        scheduler.run();
+        threadsCreated = options.maxWorkers - 1;  // run() uses the main thread too
+        fiberStats = scheduler.stats();
+#endif
+    }
+
+    auto elapsed = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start);
+    logger.flush();
+
+    if (options.stats) {
+        MemoryUsage memory = readMemoryUsage();
+        cout << "Executor: " << options.executor << ", jobs: " << options.jobs << "\n"
+             << "Elapsed: " << elapsed.count() << " ms\n"
+             << "OS threads created: " << threadsCreated << "\n"
+             << "Peak RSS: " << memory.peakRssKb << " KB, peak virtual: "
+             << memory.peakVirtualKb << " KB\n"
+             << "Memory per job: "
+             << static_cast<double>(memory.peakRssKb - baseline.rssKb) / options.jobs
+             << " KB RSS\n";
+
+#ifdef FIBER_HAVE_SCHEDULER
+        if (options.executor == "fiber") {
+            cout << "Fibers: " << fiberStats.fibers << ", stack " << fiberStats.stackSize / 1024
+                 << " KB, " << fiberStats.stacksMapped << " stacks mapped ("
+                 << fiberStats.unguardedStacks << " without guard page), "
+                 << fiberStats.switches << " switches\n";
+        }
+        cout << "Context switch: fiber " << measureFiberSwitchNs() << " ns, std::thread "
+             << measureThreadSwitchNs() << " ns\n";
+#else
+        cout << "Context switch: std::thread " << measureThreadSwitchNs() << " ns\n";
+#endif
+
+        AsyncLogger::Stats logStats = logger.stats();
+        cout << "Logger: " << logStats.lines << " lines, " << logStats.dropped << " dropped, "
+             << "max queue depth " << logStats.maxQueueDepth << ", "
+             << logStats.writeCalls << " write() calls\n";
     }
 
     cout << "End\n";
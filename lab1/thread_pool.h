@@ -0,0 +1,176 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Reusable pool of worker threads that grows with queue depth and shrinks
+// back to its minimum size once workers have been idle for a while.
+class ThreadPool {
+private:
+    std::mutex mutex_;
+    std::condition_variable taskAvailable_;
+    std::deque<std::function<void()>> tasks_;
+    std::unordered_map<std::thread::id, std::thread> workers_;
+    std::vector<std::thread> retired_;
+    size_t minWorkers_;
+    size_t maxWorkers_;
+    std::chrono::milliseconds idleTimeout_;
+    size_t idleWorkers_ = 0;
+    size_t threadsCreated_ = 0;
+    size_t peakWorkers_ = 0;
+    bool stopping_ = false;
+    std::function<void(size_t)> onWorkerStart_;  // e.g. pins the new thread to a CPU
+
+    // Starts one more worker; the caller must hold mutex_
+    void spawnWorker() {
+        std::thread worker(&ThreadPool::workerLoop, this, threadsCreated_);
+        workers_.emplace(worker.get_id(), std::move(worker));
+        ++threadsCreated_;
+        peakWorkers_ = std::max(peakWorkers_, workers_.size());
+    }
+
+    // Takes the threads of workers that have retired so they can be joined
+    std::vector<std::thread> takeRetired() {
+        std::vector<std::thread> retired;
+        retired.swap(retired_);
+        return retired;
+    }
+
+    void workerLoop(size_t index) {
+        if (onWorkerStart_) {
+            onWorkerStart_(index);
+        }
+        std::unique_lock<std::mutex> lock(mutex_);
+
+        while (true) {
+            ++idleWorkers_;
+            bool signaled = taskAvailable_.wait_for(lock, idleTimeout_, [this]() {
+                return stopping_ || !tasks_.empty();
+            });
+            --idleWorkers_;
+
+            if (!tasks_.empty()) {
+                std::function<void()> task = std::move(tasks_.front());
+                tasks_.pop_front();
+                lock.unlock();
+                task();
+                lock.lock();
+                continue;
+            }
+
+            if (stopping_) {
+                return;
+            }
+
+            // Idle for a whole timeout: hand our thread over to be joined
+            if (!signaled && workers_.size() > minWorkers_) {
+                auto self = workers_.find(std::this_thread::get_id());
+                retired_.push_back(std::move(self->second));
+                workers_.erase(self);
+                return;
+            }
+        }
+    }
+
+public:
+    // onWorkerStart runs on every new worker thread with its creation index
+    ThreadPool(size_t minWorkers, size_t maxWorkers,
+               std::chrono::milliseconds idleTimeout = std::chrono::milliseconds(100),
+               std::function<void(size_t)> onWorkerStart = nullptr)
+        : minWorkers_(minWorkers),
+          maxWorkers_(std::max<size_t>(1, std::max(minWorkers, maxWorkers))),
+          idleTimeout_(idleTimeout),
+          onWorkerStart_(std::move(onWorkerStart)) {
+        std::lock_guard<std::mutex> guard(mutex_);
+        for (size_t i = 0; i < minWorkers_; ++i) {
+            spawnWorker();
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Runs every queued task, then joins all workers
+    ~ThreadPool() {
+        std::vector<std::thread> threads;
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            stopping_ = true;
+        }
+        taskAvailable_.notify_all();
+
+        // Take every handle, live and retired, then join outside the lock;
+        // workers drain the queue before exiting
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            for (auto& entry : workers_) {
+                threads.push_back(std::move(entry.second));
+            }
+            workers_.clear();
+            for (auto& thread : takeRetired()) {
+                threads.push_back(std::move(thread));
+            }
+        }
+
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
+
+    // Queues any callable (including member functions with an object pointer)
+    // and returns a future for its result
+    template <typename F, typename... Args>
+    auto submit(F&& function, Args&&... args)
+        -> std::future<std::invoke_result_t<F, Args...>> {
+        using Result = std::invoke_result_t<F, Args...>;
+
+        auto task = std::make_shared<std::packaged_task<Result()>>(
+            std::bind(std::forward<F>(function), std::forward<Args>(args)...));
+        std::future<Result> result = task->get_future();
+
+        std::vector<std::thread> retired;
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            tasks_.emplace_back([task]() { (*task)(); });
+
+            // Grow while there is more queued work than idle workers to take it
+            if (tasks_.size() > idleWorkers_ && workers_.size() < maxWorkers_) {
+                spawnWorker();
+            }
+            retired = takeRetired();
+        }
+        taskAvailable_.notify_one();
+
+        for (auto& thread : retired) {
+            thread.join();
+        }
+        return result;
+    }
+
+    size_t workerCount() {
+        std::lock_guard<std::mutex> guard(mutex_);
+        return workers_.size();
+    }
+
+    size_t threadsCreated() {
+        std::lock_guard<std::mutex> guard(mutex_);
+        return threadsCreated_;
+    }
+
+    size_t peakWorkers() {
+        std::lock_guard<std::mutex> guard(mutex_);
+        return peakWorkers_;
+    }
+};
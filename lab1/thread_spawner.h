@@ -0,0 +1,142 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <utility>
+
+#ifndef _WIN32
+    #include <climits>
+    #include <pthread.h>
+    #include <unistd.h>
+#endif
+
+// Starts OS threads with an explicit stack and guard size. std::thread always
+// takes the platform default (8 MB of address space per thread on glibc),
+// which is what limits thread-per-connection designs long before the CPU
+// does; a 64 KB stack lets a process hold a hundred times more threads. The
+// pthread backend sets both sizes through pthread_attr_t; the std backend is
+// plain std::thread, kept for comparison and for platforms without pthreads.
+
+struct SpawnConfig {
+    enum class Api { Pthread, Std };
+
+    Api api = Api::Pthread;
+    size_t stackSize = 0;      // bytes; 0 keeps the platform default
+    size_t guardSize = 4096;   // bytes below the stack that fault on overflow
+
+    std::string describe() const {
+        std::string text = api == Api::Std ? "std::thread" : "pthread";
+        if (api == Api::Pthread) {
+            text += stackSize == 0 ? ", default stack" : ", " + std::to_string(stackSize / 1024) + " KB stack";
+            text += ", " + std::to_string(guardSize / 1024) + " KB guard";
+        }
+        return text;
+    }
+};
+
+// Joinable handle for a thread started by ThreadSpawner. Like std::thread it
+// must be joined before it is destroyed.
+class SpawnedThread {
+private:
+#ifndef _WIN32
+    pthread_t handle_{};
+    bool native_ = false;
+#endif
+    std::thread thread_;
+
+    friend class ThreadSpawner;
+
+public:
+    SpawnedThread() = default;
+    SpawnedThread(SpawnedThread&& other) noexcept { *this = std::move(other); }
+
+    SpawnedThread& operator=(SpawnedThread&& other) noexcept {
+#ifndef _WIN32
+        handle_ = other.handle_;
+        native_ = other.native_;
+        other.native_ = false;
+#endif
+        thread_ = std::move(other.thread_);
+        return *this;
+    }
+
+    bool joinable() const {
+#ifndef _WIN32
+        if (native_) {
+            return true;
+        }
+#endif
+        return thread_.joinable();
+    }
+
+    void join() {
+#ifndef _WIN32
+        if (native_) {
+            pthread_join(handle_, nullptr);
+            native_ = false;
+            return;
+        }
+#endif
+        thread_.join();
+    }
+};
+
+class ThreadSpawner {
+private:
+    SpawnConfig config_;
+
+#ifndef _WIN32
+    static void* trampoline(void* argument) {
+        std::unique_ptr<std::function<void()>> body(static_cast<std::function<void()>*>(argument));
+        (*body)();
+        return nullptr;
+    }
+
+    // PTHREAD_STACK_MIN and page size bound what pthread_attr_setstacksize takes
+    static size_t validStackSize(size_t requested) {
+        size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        size_t size = std::max<size_t>(requested, PTHREAD_STACK_MIN);
+        return (size + page - 1) / page * page;
+    }
+#endif
+
+public:
+    explicit ThreadSpawner(SpawnConfig config = SpawnConfig()) : config_(config) {}
+
+    const SpawnConfig& config() const {
+        return config_;
+    }
+
+    // Starts body on a new thread; throws std::system_error when the OS
+    // refuses (out of memory, address space, map count or thread limit)
+    SpawnedThread spawn(std::function<void()> body) const {
+        SpawnedThread thread;
+#ifndef _WIN32
+        if (config_.api == SpawnConfig::Api::Pthread) {
+            pthread_attr_t attributes;
+            pthread_attr_init(&attributes);
+            if (config_.stackSize != 0) {
+                pthread_attr_setstacksize(&attributes, validStackSize(config_.stackSize));
+            }
+            pthread_attr_setguardsize(&attributes, config_.guardSize);
+
+            auto* argument = new std::function<void()>(std::move(body));
+            int error = pthread_create(&thread.handle_, &attributes, &ThreadSpawner::trampoline, argument);
+            pthread_attr_destroy(&attributes);
+            if (error != 0) {
+                delete argument;
+                throw std::system_error(error, std::generic_category(), "pthread_create");
+            }
+            thread.native_ = true;
+            return thread;
+        }
+#endif
+        thread.thread_ = std::thread(std::move(body));
+        return thread;
+    }
+};
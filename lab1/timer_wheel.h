@@ -0,0 +1,189 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <thread>
+#include <vector>
+#include "../common/latency_histogram.h"
+
+// Hierarchical timer wheel: LEVELS wheels of SLOTS buckets each. A timer goes
+// into the lowest level whose span covers its remaining ticks; whenever a
+// lower level wraps around, the matching bucket of the level above is
+// cascaded down. Inserting and expiring are O(1) per timer, regardless of how
+// many timers are pending. The wheel is single-threaded and counts ticks; the
+// caller maps ticks to wall-clock time.
+class TimerWheel {
+public:
+    static constexpr int LEVEL_BITS = 6;
+    static constexpr int SLOTS = 1 << LEVEL_BITS;
+    static constexpr int LEVELS = 4;
+
+private:
+    struct Entry {
+        uint32_t timer;
+        uint64_t expiryTick;
+    };
+
+    std::vector<Entry> slots_[LEVELS][SLOTS];
+    uint64_t currentTick_ = 0;
+    size_t pending_ = 0;
+
+    void place(const Entry& entry) {
+        uint64_t delta = entry.expiryTick - currentTick_;
+        for (int level = 0; level < LEVELS; ++level) {
+            uint64_t span = uint64_t{1} << (LEVEL_BITS * (level + 1));
+            if (delta < span || level == LEVELS - 1) {
+                size_t slot = (entry.expiryTick >> (LEVEL_BITS * level)) & (SLOTS - 1);
+                slots_[level][slot].push_back(entry);
+                return;
+            }
+        }
+    }
+
+public:
+    uint64_t currentTick() const {
+        return currentTick_;
+    }
+
+    size_t pending() const {
+        return pending_;
+    }
+
+    // Schedules a timer; ticks that are already due fire on the next tick
+    void insert(uint32_t timer, uint64_t expiryTick) {
+        expiryTick = std::max(expiryTick, currentTick_ + 1);
+        place({timer, expiryTick});
+        ++pending_;
+    }
+
+    // Moves to the next tick and calls onExpire(timer) for every timer due on
+    // it. onExpire may insert new timers.
+    template <typename OnExpire>
+    void advance(OnExpire onExpire) {
+        ++currentTick_;
+
+        // Cascade from the highest level whose lower levels all wrapped
+        int topLevel = 0;
+        while (topLevel + 1 < LEVELS &&
+               ((currentTick_ >> (LEVEL_BITS * (topLevel + 1))) << (LEVEL_BITS * (topLevel + 1))) ==
+                   currentTick_) {
+            ++topLevel;
+        }
+        for (int level = topLevel; level > 0; --level) {
+            size_t slot = (currentTick_ >> (LEVEL_BITS * level)) & (SLOTS - 1);
+            std::vector<Entry> entries;
+            entries.swap(slots_[level][slot]);
+            for (const Entry& entry : entries) {
+                place(entry);
+            }
+        }
+
+        std::vector<Entry> due;
+        due.swap(slots_[0][currentTick_ & (SLOTS - 1)]);
+        for (const Entry& entry : due) {
+            --pending_;
+            onExpire(entry.timer);
+        }
+    }
+};
+
+// Runs periodic tasks on a few threads. Each thread owns a timer wheel and a
+// share of the tasks and runs their callbacks itself, so firing a task never
+// crosses threads. Deadlines are absolute (start + k * period) and every tick
+// sleeps until its own absolute time, so slow callbacks or oversleeping do
+// not accumulate drift. How late each firing ran is recorded per thread.
+class PeriodicScheduler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Stats {
+        uint64_t firings = 0;
+        LatencyHistogram lateness;  // nanoseconds past each deadline
+    };
+
+private:
+    struct Task {
+        std::function<void()> callback;
+        Clock::duration period;
+        int remaining;
+        Clock::time_point deadline;
+    };
+
+    struct Shard {
+        std::vector<Task> tasks;
+        Stats stats;
+    };
+
+    std::vector<Shard> shards_;
+    size_t nextShard_ = 0;
+    Clock::duration tick_;
+
+    uint64_t tickFor(Clock::time_point start, Clock::time_point deadline) const {
+        auto offset = deadline - start;
+        return static_cast<uint64_t>((offset + tick_ - Clock::duration(1)) / tick_);
+    }
+
+    void runShard(Shard& shard, Clock::time_point start) {
+        TimerWheel wheel;
+        for (uint32_t i = 0; i < shard.tasks.size(); ++i) {
+            Task& task = shard.tasks[i];
+            task.deadline = start + task.period;
+            wheel.insert(i, tickFor(start, task.deadline));
+        }
+
+        while (wheel.pending() > 0) {
+            std::this_thread::sleep_until(start + tick_ * (wheel.currentTick() + 1));
+            wheel.advance([&](uint32_t index) {
+                Task& task = shard.tasks[index];
+                auto now = Clock::now();
+                auto late = std::max(Clock::duration::zero(), now - task.deadline);
+                shard.stats.lateness.record(static_cast<uint64_t>(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(late).count()));
+                ++shard.stats.firings;
+
+                task.callback();
+                if (--task.remaining > 0) {
+                    task.deadline += task.period;
+                    wheel.insert(index, tickFor(start, task.deadline));
+                }
+            });
+        }
+    }
+
+public:
+    explicit PeriodicScheduler(size_t threads,
+                               Clock::duration tick = std::chrono::milliseconds(1))
+        : shards_(std::max<size_t>(1, threads)), tick_(tick) {}
+
+    // Adds a task that runs callback every period, repetitions times; must be
+    // called before run()
+    void schedule(Clock::duration period, int repetitions, std::function<void()> callback) {
+        if (repetitions <= 0) {
+            return;
+        }
+        shards_[nextShard_].tasks.push_back({std::move(callback), period, repetitions, {}});
+        nextShard_ = (nextShard_ + 1) % shards_.size();
+    }
+
+    // Runs every task to completion and returns the merged statistics
+    Stats run() {
+        auto start = Clock::now();
+        std::vector<std::thread> threads;
+        for (auto& shard : shards_) {
+            threads.emplace_back(&PeriodicScheduler::runShard, this, std::ref(shard), start);
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+
+        Stats total;
+        for (const auto& shard : shards_) {
+            total.firings += shard.stats.firings;
+            total.lateness.merge(shard.stats.lateness);
+        }
+        return total;
+    }
+};
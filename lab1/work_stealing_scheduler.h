@@ -0,0 +1,198 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Fixed set of workers, each owning a deque of tasks. Owners pop from the
+// back of their own deque (most recent first) and idle workers steal from the
+// front of the other deques (oldest first), so long jobs that land on one
+// worker are picked up by whoever runs out of work first.
+class WorkStealingScheduler {
+public:
+    struct Stats {
+        uint64_t localTasks = 0;
+        uint64_t stolenTasks = 0;
+        uint64_t failedSteals = 0;
+    };
+
+private:
+    struct alignas(64) WorkerQueue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+        std::atomic<uint64_t> localTasks{0};
+        std::atomic<uint64_t> stolenTasks{0};
+        std::atomic<uint64_t> failedSteals{0};
+    };
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues_;
+    std::vector<std::thread> threads_;
+    std::atomic<size_t> queued_{0};
+    std::atomic<size_t> pending_{0};
+    std::atomic<size_t> sleepers_{0};
+    std::atomic<size_t> nextQueue_{0};
+    std::atomic<bool> stopping_{false};
+    std::mutex idleMutex_;
+    std::condition_variable workAvailable_;
+    std::condition_variable allDone_;
+    std::function<void(size_t)> onWorkerStart_;
+
+    // Index of the worker running on this thread, or -1 outside the scheduler
+    static int& currentWorker() {
+        static thread_local int index = -1;
+        return index;
+    }
+
+    bool popLocal(size_t self, std::function<void()>& task) {
+        WorkerQueue& queue = *queues_[self];
+        std::lock_guard<std::mutex> guard(queue.mutex);
+        if (queue.tasks.empty()) {
+            return false;
+        }
+        task = std::move(queue.tasks.back());
+        queue.tasks.pop_back();
+        queue.localTasks.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    bool steal(size_t self, uint32_t& randomState, std::function<void()>& task) {
+        size_t count = queues_.size();
+
+        // xorshift32 picks a random starting victim so thieves spread out
+        randomState ^= randomState << 13;
+        randomState ^= randomState >> 17;
+        randomState ^= randomState << 5;
+        size_t start = randomState % count;
+
+        for (size_t i = 0; i < count; ++i) {
+            size_t victim = (start + i) % count;
+            if (victim == self) {
+                continue;
+            }
+
+            WorkerQueue& queue = *queues_[victim];
+            std::lock_guard<std::mutex> guard(queue.mutex);
+            if (!queue.tasks.empty()) {
+                task = std::move(queue.tasks.front());
+                queue.tasks.pop_front();
+                queues_[self]->stolenTasks.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        queues_[self]->failedSteals.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    void workerLoop(size_t self) {
+        currentWorker() = static_cast<int>(self);
+        if (onWorkerStart_) {
+            onWorkerStart_(self);
+        }
+        uint32_t randomState = static_cast<uint32_t>(self) * 2654435761u + 1;
+
+        while (true) {
+            std::function<void()> task;
+            if (popLocal(self, task) || steal(self, randomState, task)) {
+                queued_.fetch_sub(1);
+                task();
+                if (pending_.fetch_sub(1) == 1) {
+                    std::lock_guard<std::mutex> guard(idleMutex_);
+                    allDone_.notify_all();
+                }
+                continue;
+            }
+
+            // Nothing to pop or steal: sleep until more work is queued
+            std::unique_lock<std::mutex> lock(idleMutex_);
+            sleepers_.fetch_add(1);
+            workAvailable_.wait(lock, [this]() {
+                return stopping_.load() || queued_.load() > 0;
+            });
+            sleepers_.fetch_sub(1);
+            if (stopping_.load() && queued_.load() == 0) {
+                return;
+            }
+        }
+    }
+
+public:
+    // onWorkerStart runs on each worker thread with its index before it takes work
+    explicit WorkStealingScheduler(size_t workerCount,
+                                   std::function<void(size_t)> onWorkerStart = nullptr)
+        : onWorkerStart_(std::move(onWorkerStart)) {
+        if (workerCount == 0) {
+            workerCount = 1;
+        }
+        for (size_t i = 0; i < workerCount; ++i) {
+            queues_.push_back(std::make_unique<WorkerQueue>());
+        }
+        for (size_t i = 0; i < workerCount; ++i) {
+            threads_.emplace_back(&WorkStealingScheduler::workerLoop, this, i);
+        }
+    }
+
+    WorkStealingScheduler(const WorkStealingScheduler&) = delete;
+    WorkStealingScheduler& operator=(const WorkStealingScheduler&) = delete;
+
+    ~WorkStealingScheduler() {
+        wait();
+        {
+            std::lock_guard<std::mutex> guard(idleMutex_);
+            stopping_ = true;
+        }
+        workAvailable_.notify_all();
+        for (auto& thread : threads_) {
+            thread.join();
+        }
+    }
+
+    // Queues a task on the calling worker's deque, or round-robin across the
+    // workers when called from outside the scheduler
+    void submit(std::function<void()> task) {
+        int worker = currentWorker();
+        size_t target = worker >= 0 ? static_cast<size_t>(worker)
+                                    : nextQueue_.fetch_add(1) % queues_.size();
+
+        pending_.fetch_add(1);
+        queued_.fetch_add(1);
+        {
+            WorkerQueue& queue = *queues_[target];
+            std::lock_guard<std::mutex> guard(queue.mutex);
+            queue.tasks.push_back(std::move(task));
+        }
+
+        if (sleepers_.load() > 0) {
+            { std::lock_guard<std::mutex> guard(idleMutex_); }
+            workAvailable_.notify_one();
+        }
+    }
+
+    // Blocks until every submitted task has finished
+    void wait() {
+        std::unique_lock<std::mutex> lock(idleMutex_);
+        allDone_.wait(lock, [this]() { return pending_.load() == 0; });
+    }
+
+    size_t workerCount() const {
+        return threads_.size();
+    }
+
+    // Totals across workers; only meaningful once wait() has returned
+    Stats stats() const {
+        Stats total;
+        for (const auto& queue : queues_) {
+            total.localTasks += queue->localTasks.load(std::memory_order_relaxed);
+            total.stolenTasks += queue->stolenTasks.load(std::memory_order_relaxed);
+            total.failedSteals += queue->failedSteals.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+};
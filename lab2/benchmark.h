@@ -0,0 +1,125 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../common/latency_histogram.h"
+
+// Shared pieces of the lab2 contention benchmarks: phase control for
+// warmup/measurement, the per-thread operation loop, and CSV reporting.
+
+enum BenchPhase : int {
+    BENCH_WARMUP = 0,
+    BENCH_MEASURE = 1,
+    BENCH_STOP = 2
+};
+
+struct BenchConfig {
+    int warmupMs = 200;
+    int durationMs = 1000;
+    std::vector<int> writerCounts{1};
+    std::vector<int> readerCounts{0};
+};
+
+// Per-thread (or per-process) measurement; plain data so it can be placed in
+// shared memory by the process benchmark
+struct BenchSample {
+    uint64_t operations = 0;
+    LatencyHistogram latency;
+};
+
+struct BenchResult {
+    std::string mode;
+    int writers = 0;
+    int readers = 0;
+    double seconds = 0;
+    BenchSample writes;
+    BenchSample reads;
+    std::string placement = "none";  // thread placement policy of the run
+};
+
+// Parses "1,2,4,8" into a list of non-negative counts
+inline std::vector<int> parseCountList(const std::string& text) {
+    std::vector<int> counts;
+    std::stringstream stream(text);
+    std::string item;
+
+    while (std::getline(stream, item, ',')) {
+        int count = std::stoi(item);
+        if (count < 0) {
+            throw std::invalid_argument("Counts must not be negative: " + text);
+        }
+        counts.push_back(count);
+    }
+    if (counts.empty()) {
+        throw std::invalid_argument("Empty count list");
+    }
+    return counts;
+}
+
+// Runs operation() until the phase reaches BENCH_STOP. Only operations that
+// complete during BENCH_MEASURE are counted. Each latency is the gap between
+// consecutive clock reads, so the loop pays for one clock read per operation.
+template <typename Operation>
+void runBenchLoop(const std::atomic<int>& phase, BenchSample& sample, Operation operation) {
+    using Clock = std::chrono::steady_clock;
+    auto previous = Clock::now();
+
+    while (true) {
+        int current = phase.load(std::memory_order_relaxed);
+        if (current == BENCH_STOP) {
+            break;
+        }
+
+        operation();
+        auto now = Clock::now();
+        if (current == BENCH_MEASURE) {
+            sample.latency.record(static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(now - previous).count()));
+            ++sample.operations;
+        }
+        previous = now;
+    }
+}
+
+// Drives the warmup and measurement phases and returns the measured seconds
+inline double runBenchPhases(const BenchConfig& config, std::atomic<int>& phase) {
+    phase.store(BENCH_WARMUP);
+    std::this_thread::sleep_for(std::chrono::milliseconds(config.warmupMs));
+
+    auto start = std::chrono::steady_clock::now();
+    phase.store(BENCH_MEASURE);
+    std::this_thread::sleep_for(std::chrono::milliseconds(config.durationMs));
+    phase.store(BENCH_STOP);
+    auto end = std::chrono::steady_clock::now();
+
+    return std::chrono::duration<double>(end - start).count();
+}
+
+inline void printBenchCsvHeader(std::ostream& out) {
+    out << "mode,writers,readers,seconds,"
+        << "write_ops_per_sec,write_p50_ns,write_p99_ns,write_p999_ns,"
+        << "read_ops_per_sec,read_p50_ns,read_p99_ns,read_p999_ns,placement\n";
+}
+
+inline void printBenchCsvRow(std::ostream& out, const BenchResult& result) {
+    auto printSample = [&](const BenchSample& sample) {
+        out << sample.operations / result.seconds << ","
+            << sample.latency.percentile(50) << ","
+            << sample.latency.percentile(99) << ","
+            << sample.latency.percentile(99.9);
+    };
+
+    out << result.mode << "," << result.writers << "," << result.readers << ","
+        << result.seconds << ",";
+    printSample(result.writes);
+    out << ",";
+    printSample(result.reads);
+    out << "," << result.placement << "\n";
+}
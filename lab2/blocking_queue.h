@@ -0,0 +1,84 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+// Bounded FIFO behind one mutex, with condition variables for "not empty"
+// and "not full": the textbook producer/consumer queue, kept as the baseline
+// for the lock-free MpmcRing. Batches move under a single lock acquisition.
+// close() wakes every blocked thread so a benchmark can stop them.
+template <typename T>
+class BlockingQueue {
+private:
+    std::mutex mutex_;
+    std::condition_variable notEmpty_;
+    std::condition_variable notFull_;
+    std::vector<T> items_;
+    size_t head_ = 0;   // next item to pop
+    size_t count_ = 0;  // items queued
+    bool closed_ = false;
+
+public:
+    explicit BlockingQueue(size_t capacity) : items_(capacity) {}
+
+    BlockingQueue(const BlockingQueue&) = delete;
+    BlockingQueue& operator=(const BlockingQueue&) = delete;
+
+    // Waits for room, then pushes as many of the count values as fit.
+    // Returns how many were pushed, 0 once the queue is closed.
+    size_t push(const T* values, size_t count) {
+        size_t pushed;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            notFull_.wait(lock, [this]() { return closed_ || count_ < items_.size(); });
+            if (closed_) {
+                return 0;
+            }
+            pushed = std::min(count, items_.size() - count_);
+            for (size_t i = 0; i < pushed; ++i) {
+                items_[(head_ + count_ + i) % items_.size()] = values[i];
+            }
+            count_ += pushed;
+        }
+        if (pushed == 1) {
+            notEmpty_.notify_one();
+        } else {
+            notEmpty_.notify_all();
+        }
+        return pushed;
+    }
+
+    // Waits for an item, then pops up to count of them. Returns how many were
+    // popped, 0 once the queue is closed and drained.
+    size_t pop(T* values, size_t count) {
+        size_t popped;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            notEmpty_.wait(lock, [this]() { return closed_ || count_ > 0; });
+            popped = std::min(count, count_);
+            for (size_t i = 0; i < popped; ++i) {
+                values[i] = items_[(head_ + i) % items_.size()];
+            }
+            head_ = (head_ + popped) % items_.size();
+            count_ -= popped;
+        }
+        if (popped == 1) {
+            notFull_.notify_one();
+        } else if (popped > 1) {
+            notFull_.notify_all();
+        }
+        return popped;
+    }
+
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            closed_ = true;
+        }
+        notEmpty_.notify_all();
+        notFull_.notify_all();
+    }
+};
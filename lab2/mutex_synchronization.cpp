@@ -1,49 +1,317 @@
 #include <iostream>
+#include <fstream>
 #include <thread>
 #include <mutex>
+#include <shared_mutex>
+#include <atomic>
 #include <chrono>
-#include <random>
 #include <vector>
+#include <memory>
+#include <string>
+#include <sstream>
 #include <stdexcept>
+#include "benchmark.h"
+#include "blocking_queue.h"
+#include "../common/async_logger.h"
+#include "../common/rng.h"
+#include "../common/latency_recorder.h"
+#include "../common/affinity.h"
+#include "../common/mpmc_ring.h"
+#include "../common/adaptive_mutex.h"
 
+using std::atomic;
 using std::cerr;
 using std::cin;
 using std::cout;
 using std::exception;
 using std::invalid_argument;
 using std::lock_guard;
-using std::mt19937;
 using std::mutex;
-using std::random_device;
+using std::ofstream;
+using std::ostream;
+using std::shared_lock;
+using std::shared_mutex;
+using std::string;
 using std::thread;
-using std::uniform_int_distribution;
+using std::unique_lock;
 using std::vector;
 
 constexpr int MAX_SLEEP_MS = 2000;
+constexpr size_t CACHE_LINE_SIZE = 64;
+constexpr size_t QUEUE_CAPACITY = 1024;
+
+// How writers update the counter and readers observe it
+enum class CounterMode {
+    Mutex,          // one counter behind counterMutex
+    AdaptiveMutex,  // the same counter behind counterAdaptiveMutex (spin, then futex)
+    Atomic,         // one std::atomic counter
+    Sharded,        // one cache-line padded slot per writer, summed by readers
+    SharedMutex,    // writers lock exclusively, readers share the lock
+    Seqlock,        // writers bump a sequence number, readers retry on change
+    MpmcQueue,      // producer/consumer: writers push items through an MpmcRing
+    MutexQueue      // producer/consumer: mutex + condition_variable queue
+};
+
+// Command line configuration; empty counts are asked for on stdin. Benchmark
+// mode accepts comma-separated lists for the modes and counts and sweeps them.
+struct Options {
+    CounterMode mode = CounterMode::Mutex;
+    vector<CounterMode> modes{CounterMode::Mutex};
+    vector<int> writerCounts;
+    vector<int> readerCounts;
+    long incrementsPerWriter = 1;
+    long readsPerReader = 1;
+    long readRatio = 0;
+    bool sleep = true;
+    bool bench = false;
+    bool logBinary = false;
+    bool logStats = false;
+    bool logDrop = false;
+    bool seeded = false;
+    uint64_t seed = 0;
+    BenchConfig benchConfig;
+    string csvPath;
+    string latencyJson;  // latency report written here at exit
+    ThreadPlacement placement;
+    uint32_t latencySample = 16;  // time one lock acquisition in N per thread
+    size_t batch = 1;             // items per push and pop in the queue modes
+};
+
+// Counter slot owned by a single writer, padded so neighbours never share a line
+struct alignas(CACHE_LINE_SIZE) CounterShard {
+    atomic<long> value{0};
+};
+
+// Sequence lock: readers never write shared memory, they retry instead when
+// a writer was active (odd sequence) or finished while they were reading
+class SeqlockCounter {
+private:
+    atomic<unsigned> sequence_{0};
+    atomic<long> value_{0};
+    mutex writerMutex_;
+
+public:
+    void increment() {
+        lock_guard<mutex> guard(writerMutex_);
+        unsigned sequence = sequence_.load(std::memory_order_relaxed);
+        sequence_.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        value_.store(value_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        sequence_.store(sequence + 2, std::memory_order_release);
+    }
+
+    void reset() {
+        sequence_.store(0);
+        value_.store(0);
+    }
+
+    long read() const {
+        while (true) {
+            unsigned before = sequence_.load(std::memory_order_acquire);
+            long value = value_.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            unsigned after = sequence_.load(std::memory_order_relaxed);
+            if (before == after && (before & 1) == 0) {
+                return value;
+            }
+        }
+    }
+};
+
+Options options;
 
 // Shared variable between writer and reader threads
-int sharedCounter = 0;
+long sharedCounter = 0;
 
 // Mutex to synchronize access to the shared variable
 mutex counterMutex;
+// Drop-in alternative to counterMutex, for --mode adaptive_mutex
+AdaptiveMutex counterAdaptiveMutex;
+
+const int COUNTER_MUTEX_WAIT = LatencyRecorder::instance().metric("counter_mutex.wait");
+const int COUNTER_MUTEX_HOLD = LatencyRecorder::instance().metric("counter_mutex.hold");
+
+// lock_guard for the counter's mutex that records how long the lock took to
+// get and how long it was held
+template <typename Mutex>
+class TimedCounterLock {
+private:
+    Mutex& mutex_;
+    uint64_t acquiredNs_ = 0;
+
+public:
+    explicit TimedCounterLock(Mutex& mutex) : mutex_(mutex) {
+        if (!LatencyRecorder::instance().sample()) {
+            mutex_.lock();
+            return;
+        }
+        uint64_t start = LatencyRecorder::now();
+        mutex_.lock();
+        acquiredNs_ = LatencyRecorder::now();
+        LatencyRecorder::instance().record(COUNTER_MUTEX_WAIT, acquiredNs_ - start);
+    }
+
+    TimedCounterLock(const TimedCounterLock&) = delete;
+    TimedCounterLock& operator=(const TimedCounterLock&) = delete;
+
+    ~TimedCounterLock() {
+        if (acquiredNs_ == 0) {
+            mutex_.unlock();
+            return;
+        }
+        uint64_t held = LatencyRecorder::now() - acquiredNs_;
+        mutex_.unlock();
+        LatencyRecorder::instance().record(COUNTER_MUTEX_HOLD, held);
+    }
+};
+
+// Lock-free alternatives to sharedCounter + counterMutex
+atomic<long> atomicCounter{0};
+// Allocated on the NUMA node of the writers when --placement picks one
+vector<CounterShard, NodeAllocator<CounterShard>> counterShards;
+shared_mutex counterSharedMutex;
+SeqlockCounter seqlockCounter;
+
+// Released once every thread has been created, so timing excludes spawning
+atomic<bool> startSignal{false};
+
+const char* modeName(CounterMode mode) {
+    switch (mode) {
+        case CounterMode::Mutex: return "mutex";
+        case CounterMode::AdaptiveMutex: return "adaptive_mutex";
+        case CounterMode::Atomic: return "atomic";
+        case CounterMode::Sharded: return "sharded";
+        case CounterMode::SharedMutex: return "shared_mutex";
+        case CounterMode::Seqlock: return "seqlock";
+        case CounterMode::MpmcQueue: return "mpmc_queue";
+        case CounterMode::MutexQueue: return "mutex_queue";
+    }
+    return "unknown";
+}
+
+CounterMode parseMode(const string& name) {
+    if (name == "mutex") return CounterMode::Mutex;
+    if (name == "adaptive_mutex") return CounterMode::AdaptiveMutex;
+    if (name == "atomic") return CounterMode::Atomic;
+    if (name == "sharded") return CounterMode::Sharded;
+    if (name == "shared_mutex") return CounterMode::SharedMutex;
+    if (name == "seqlock") return CounterMode::Seqlock;
+    if (name == "mpmc_queue") return CounterMode::MpmcQueue;
+    if (name == "mutex_queue") return CounterMode::MutexQueue;
+    throw invalid_argument("Unknown mode: " + name);
+}
+
+vector<CounterMode> parseModeList(const string& text) {
+    vector<CounterMode> modes;
+    std::stringstream stream(text);
+    string item;
+    while (std::getline(stream, item, ',')) {
+        modes.push_back(parseMode(item));
+    }
+    if (modes.empty()) {
+        throw invalid_argument("Empty mode list");
+    }
+    return modes;
+}
+
+bool isQueueMode(CounterMode mode) {
+    return mode == CounterMode::MpmcQueue || mode == CounterMode::MutexQueue;
+}
+
+void incrementCounter(int writerId) {
+    switch (options.mode) {
+        case CounterMode::Mutex: {
+            TimedCounterLock guard(counterMutex);
+            ++sharedCounter;
+            break;
+        }
+        case CounterMode::AdaptiveMutex: {
+            TimedCounterLock guard(counterAdaptiveMutex);
+            ++sharedCounter;
+            break;
+        }
+        case CounterMode::Atomic:
+            atomicCounter.fetch_add(1, std::memory_order_relaxed);
+            break;
+        case CounterMode::Sharded: {
+            // Only this writer updates its slot, so no read-modify-write is needed
+            atomic<long>& slot = counterShards[writerId].value;
+            slot.store(slot.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            break;
+        }
+        case CounterMode::SharedMutex: {
+            unique_lock<shared_mutex> guard(counterSharedMutex);
+            ++sharedCounter;
+            break;
+        }
+        case CounterMode::Seqlock:
+            seqlockCounter.increment();
+            break;
+        case CounterMode::MpmcQueue:
+        case CounterMode::MutexQueue:
+            break;  // the queue modes move items instead, see runQueueBenchmark
+    }
+}
+
+long readCounter() {
+    switch (options.mode) {
+        case CounterMode::Mutex: {
+            TimedCounterLock guard(counterMutex);
+            return sharedCounter;
+        }
+        case CounterMode::AdaptiveMutex: {
+            TimedCounterLock guard(counterAdaptiveMutex);
+            return sharedCounter;
+        }
+        case CounterMode::Atomic:
+            return atomicCounter.load(std::memory_order_relaxed);
+        case CounterMode::Sharded: {
+            long total = 0;
+            for (const auto& shard : counterShards) {
+                total += shard.value.load(std::memory_order_relaxed);
+            }
+            return total;
+        }
+        case CounterMode::SharedMutex: {
+            shared_lock<shared_mutex> guard(counterSharedMutex);
+            return sharedCounter;
+        }
+        case CounterMode::Seqlock:
+            return seqlockCounter.read();
+        case CounterMode::MpmcQueue:
+        case CounterMode::MutexQueue:
+            break;
+    }
+    return 0;
+}
+
+void waitForStart() {
+    while (!startSignal.load(std::memory_order_acquire)) {
+        std::this_thread::yield();
+    }
+}
+
+// Sleeps for a random time between 0 and 2 seconds, unless disabled. Each
+// thread draws from its own stream, so a --seed run repeats the same sleeps.
+void randomSleep(uint64_t stream) {
+    if (!options.sleep) {
+        return;
+    }
+    seedThreadRng(stream);
+    int sleepTime = threadRng().uniformInt(0, MAX_SLEEP_MS);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(sleepTime));
+}
 
 // Writer thread: increments the shared counter
 void writerThread(int id) {
     try {
-        cout << "Writer thread " << id << " started\n";
-
-        // Generate random sleep time between 0 and 2 seconds
-        random_device rd;
-        mt19937 gen(rd());
-        uniform_int_distribution<> dist(0, MAX_SLEEP_MS);
-        int sleepTime = dist(gen);
-        
-        std::this_thread::sleep_for(std::chrono::milliseconds(sleepTime));
-
-        // Increment shared counter with mutex protection
-        {
-            lock_guard<mutex> guard(counterMutex);
-            ++sharedCounter;
+        AsyncLogger::instance().log("Writer thread {} started", id);
+        waitForStart();
+        randomSleep(2 * static_cast<uint64_t>(id));
+
+        for (long i = 0; i < options.incrementsPerWriter; ++i) {
+            incrementCounter(id);
         }
     } catch (const exception& e) {
         cerr << "Exception in writer thread " << id << ": " << e.what() << "\n";
@@ -53,67 +321,409 @@ void writerThread(int id) {
 // Reader thread: reads and displays the shared counter value
 void readerThread(int id) {
     try {
-        cout << "Reader thread " << id << " started\n";
+        AsyncLogger::instance().log("Reader thread {} started", id);
+        waitForStart();
+        randomSleep(2 * static_cast<uint64_t>(id) + 1);
 
-        // Generate random sleep time between 0 and 2 seconds
-        random_device rd;
-        mt19937 gen(rd());
-        uniform_int_distribution<> dist(0, MAX_SLEEP_MS);
-        int sleepTime = dist(gen);
-        
-        std::this_thread::sleep_for(std::chrono::milliseconds(sleepTime));
-
-        // Read and display shared counter with mutex protection
-        {
-            lock_guard<mutex> guard(counterMutex);
-            cout << "Shared counter value: " << sharedCounter << "\n";
+        long value = 0;
+        for (long i = 0; i < options.readsPerReader; ++i) {
+            value = readCounter();
         }
+        AsyncLogger::instance().log("Shared counter value: {}", value);
     } catch (const exception& e) {
         cerr << "Exception in reader thread " << id << ": " << e.what() << "\n";
     }
 }
 
-int main() {
+void parseOptions(int argc, char* argv[]) {
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (arg == "--mode" && hasValue) {
+            options.modes = parseModeList(argv[++i]);
+        } else if (arg == "--writers" && hasValue) {
+            options.writerCounts = parseCountList(argv[++i]);
+        } else if (arg == "--readers" && hasValue) {
+            options.readerCounts = parseCountList(argv[++i]);
+        } else if (arg == "--increments" && hasValue) {
+            options.incrementsPerWriter = std::stol(argv[++i]);
+        } else if (arg == "--reads" && hasValue) {
+            options.readsPerReader = std::stol(argv[++i]);
+        } else if (arg == "--ratio" && hasValue) {
+            options.readRatio = std::stol(argv[++i]);
+        } else if (arg == "--no-sleep") {
+            options.sleep = false;
+        } else if (arg == "--seed" && hasValue) {
+            options.seed = std::stoull(argv[++i]);
+            options.seeded = true;
+        } else if (arg == "--log-binary") {
+            options.logBinary = true;
+        } else if (arg == "--log-stats") {
+            options.logStats = true;
+        } else if (arg == "--log-drop") {
+            options.logDrop = true;
+        } else if (arg == "--bench") {
+            options.bench = true;
+        } else if (arg == "--warmup-ms" && hasValue) {
+            options.benchConfig.warmupMs = std::stoi(argv[++i]);
+        } else if (arg == "--duration-ms" && hasValue) {
+            options.benchConfig.durationMs = std::stoi(argv[++i]);
+        } else if (arg == "--csv" && hasValue) {
+            options.csvPath = argv[++i];
+        } else if (arg == "--latency-json" && hasValue) {
+            options.latencyJson = argv[++i];
+        } else if (arg == "--placement" && hasValue) {
+            options.placement = ThreadPlacement::parse(argv[++i]);
+        } else if (arg == "--latency-sample" && hasValue) {
+            options.latencySample = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "--batch" && hasValue) {
+            options.batch = std::stoul(argv[++i]);
+        } else {
+            throw invalid_argument("Unknown option: " + arg + "\n"
+                "Usage: mutex_synchronization\n"
+                "       [--mode mutex|adaptive_mutex|atomic|sharded|shared_mutex|seqlock]\n"
+                "       [--writers N] [--readers M] [--increments K]\n"
+                "       [--reads R | --ratio READS_PER_INCREMENT] [--no-sleep] [--seed S]\n"
+                "       [--log-binary] [--log-stats] [--log-drop] [--latency-json PATH|-]\n"
+                "       [--latency-sample N] [--placement none|compact|scatter|node[:N]]\n"
+                "       mutex_synchronization --bench [--mode LIST] [--writers LIST]\n"
+                "       [--readers LIST] [--warmup-ms MS] [--duration-ms MS] [--csv PATH]\n"
+                "       [--placement none|compact|scatter|node[:N]]\n"
+                "       mutex_synchronization --bench --mode mpmc_queue,mutex_queue\n"
+                "       [--writers LIST] [--readers LIST] [--batch N]");
+        }
+    }
+    if (!options.bench && (options.modes.size() != 1 || options.writerCounts.size() > 1 ||
+                           options.readerCounts.size() > 1)) {
+        throw invalid_argument("Lists of modes or counts are only accepted with --bench.");
+    }
+    options.mode = options.modes.front();
+    if (!options.bench && isQueueMode(options.mode)) {
+        throw invalid_argument("The queue modes only run with --bench.");
+    }
+    if (options.batch < 1 || options.batch > QUEUE_CAPACITY) {
+        throw invalid_argument("--batch must be between 1 and " + std::to_string(QUEUE_CAPACITY));
+    }
+    if (options.incrementsPerWriter < 0 || options.readsPerReader < 0 || options.readRatio < 0) {
+        throw invalid_argument("Increments and reads must not be negative.");
+    }
+
+    // A ratio sizes each reader's work relative to each writer's
+    if (options.readRatio > 0) {
+        options.readsPerReader = options.readRatio * options.incrementsPerWriter;
+    }
+}
+
+void resetShards(int writerCount) {
+    NodeAllocator<CounterShard> allocator(options.placement.memoryNode());
+    counterShards = vector<CounterShard, NodeAllocator<CounterShard>>(writerCount, allocator);
+}
+
+// Clears every counter representation between benchmark configurations
+void resetCounters(int writerCount) {
+    sharedCounter = 0;
+    atomicCounter.store(0);
+    resetShards(writerCount);
+    seqlockCounter.reset();
+    counterAdaptiveMutex.resetStats();
+}
+
+// Runs one mode with a fixed number of writers and readers doing sustained
+// increments and reads through the warmup and measurement phases
+BenchResult runBenchmark(CounterMode mode, int writerCount, int readerCount) {
+    options.mode = mode;
+    resetCounters(writerCount);
+
+    atomic<int> phase{BENCH_WARMUP};
+    atomic<long> readSink{0};
+    vector<BenchSample> samples(writerCount + readerCount);
+    vector<thread> threads;
+    threads.reserve(writerCount + readerCount);
+
+    for (int i = 0; i < writerCount; ++i) {
+        threads.emplace_back([&, i]() {
+            runBenchLoop(phase, samples[i], [i]() { incrementCounter(i); });
+        });
+        options.placement.pinThread(threads.back(), i);
+    }
+    for (int i = 0; i < readerCount; ++i) {
+        threads.emplace_back([&, i]() {
+            long lastValue = 0;
+            runBenchLoop(phase, samples[writerCount + i], [&]() { lastValue = readCounter(); });
+            readSink.fetch_add(lastValue, std::memory_order_relaxed);
+        });
+        options.placement.pinThread(threads.back(), writerCount + i);
+    }
+
+    BenchResult result;
+    result.mode = modeName(mode);
+    result.writers = writerCount;
+    result.readers = readerCount;
+    result.placement = options.placement.name();
+    result.seconds = runBenchPhases(options.benchConfig, phase);
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    for (int i = 0; i < writerCount + readerCount; ++i) {
+        BenchSample& target = i < writerCount ? result.writes : result.reads;
+        target.operations += samples[i].operations;
+        target.latency.merge(samples[i].latency);
+    }
+    return result;
+}
+
+// Item handed from a producer to a consumer, stamped when it was pushed
+struct WorkItem {
+    uint64_t enqueuedNs;
+    uint64_t payload;
+};
+
+// The two queues behind one interface. push and pop move up to count items
+// and return how many moved; the lock-free ring returns 0 instead of waiting.
+struct LockFreeWorkQueue {
+    MpmcRing<WorkItem, QUEUE_CAPACITY> ring;
+
+    size_t push(const WorkItem* items, size_t count) {
+        return count == 1 ? static_cast<size_t>(ring.tryPush(items[0]))
+                          : ring.tryPushBatch(items, count);
+    }
+    size_t pop(WorkItem* items, size_t count) {
+        return count == 1 ? static_cast<size_t>(ring.tryPop(items[0]))
+                          : ring.tryPopBatch(items, count);
+    }
+    void close() {}
+};
+
+struct LockedWorkQueue {
+    BlockingQueue<WorkItem> queue{QUEUE_CAPACITY};
+
+    size_t push(const WorkItem* items, size_t count) {
+        return queue.push(items, count);
+    }
+    size_t pop(WorkItem* items, size_t count) {
+        return queue.pop(items, count);
+    }
+    void close() {
+        queue.close();
+    }
+};
+
+// Producer/consumer run: writers push batches of options.batch items and
+// readers pop up to that many at a time. Write and read operations count
+// items; the write latency is per push call and the read latency is how long
+// each item waited in the queue.
+template <typename Queue>
+BenchResult runQueueBenchmark(CounterMode mode, int writerCount, int readerCount) {
+    auto queue = std::make_unique<Queue>();
+    atomic<int> phase{BENCH_WARMUP};
+    vector<BenchSample> samples(writerCount + readerCount);
+    vector<thread> threads;
+    threads.reserve(writerCount + readerCount);
+
+    for (int i = 0; i < writerCount; ++i) {
+        threads.emplace_back([&, i]() {
+            vector<WorkItem> batch(options.batch);
+            uint64_t payload = 0;
+            while (true) {
+                int current = phase.load(std::memory_order_relaxed);
+                if (current == BENCH_STOP) {
+                    break;
+                }
+                uint64_t start = LatencyRecorder::now();
+                for (WorkItem& item : batch) {
+                    item = {start, payload++};
+                }
+                size_t pushed = 0;
+                while (pushed < batch.size() &&
+                       phase.load(std::memory_order_relaxed) != BENCH_STOP) {
+                    size_t count = queue->push(batch.data() + pushed, batch.size() - pushed);
+                    if (count == 0) {
+                        std::this_thread::yield();  // full
+                    }
+                    pushed += count;
+                }
+                if (current == BENCH_MEASURE) {
+                    samples[i].latency.record(LatencyRecorder::now() - start);
+                    samples[i].operations += pushed;
+                }
+            }
+        });
+        options.placement.pinThread(threads.back(), i);
+    }
+    for (int i = 0; i < readerCount; ++i) {
+        threads.emplace_back([&, i]() {
+            BenchSample& sample = samples[writerCount + i];
+            vector<WorkItem> batch(options.batch);
+            while (true) {
+                int current = phase.load(std::memory_order_relaxed);
+                if (current == BENCH_STOP) {
+                    break;
+                }
+                size_t count = queue->pop(batch.data(), batch.size());
+                if (count == 0) {
+                    std::this_thread::yield();  // empty
+                    continue;
+                }
+                if (current == BENCH_MEASURE) {
+                    uint64_t now = LatencyRecorder::now();
+                    for (size_t k = 0; k < count; ++k) {
+                        sample.latency.record(now - batch[k].enqueuedNs);
+                    }
+                    sample.operations += count;
+                }
+            }
+        });
+        options.placement.pinThread(threads.back(), writerCount + i);
+    }
+
+    BenchResult result;
+    result.mode = modeName(mode);
+    if (options.batch > 1) {
+        result.mode += "_batch" + std::to_string(options.batch);
+    }
+    result.writers = writerCount;
+    result.readers = readerCount;
+    result.placement = options.placement.name();
+    result.seconds = runBenchPhases(options.benchConfig, phase);
+    queue->close();  // wakes threads blocked on a full or empty locked queue
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    for (int i = 0; i < writerCount + readerCount; ++i) {
+        BenchSample& target = i < writerCount ? result.writes : result.reads;
+        target.operations += samples[i].operations;
+        target.latency.merge(samples[i].latency);
+    }
+    return result;
+}
+
+// Contention counters of counterAdaptiveMutex since the counters were reset
+void printAdaptiveMutexStats(ostream& out, const AdaptiveMutexStats& stats) {
+    double contended = stats.acquisitions == 0 ? 0.0 : 100.0 * stats.contended / stats.acquisitions;
+    out << stats.acquisitions << " acquisitions, " << stats.contended << " contended ("
+        << contended << "%), " << stats.parks << " parks, spin estimate "
+        << counterAdaptiveMutex.spinEstimate() << " pauses\n";
+}
+
+// Sweeps every mode over every writer/reader combination, one CSV row each.
+// adaptive_mutex rows are followed by the lock's counters on stderr.
+void runBenchmarks(ostream& out) {
+    vector<int> writerCounts = options.writerCounts.empty() ? vector<int>{1} : options.writerCounts;
+    vector<int> readerCounts = options.readerCounts.empty() ? vector<int>{0} : options.readerCounts;
+
+    printBenchCsvHeader(out);
+    for (CounterMode mode : options.modes) {
+        bool queue = isQueueMode(mode);
+        // A queue needs both sides; without --readers it gets one consumer
+        const vector<int>& modeReaderCounts =
+            queue && options.readerCounts.empty() ? vector<int>{1} : readerCounts;
+        for (int writers : writerCounts) {
+            for (int readers : modeReaderCounts) {
+                if (writers + readers == 0 || (queue && (writers == 0 || readers == 0))) {
+                    continue;
+                }
+                BenchResult result;
+                if (mode == CounterMode::MpmcQueue) {
+                    result = runQueueBenchmark<LockFreeWorkQueue>(mode, writers, readers);
+                } else if (mode == CounterMode::MutexQueue) {
+                    result = runQueueBenchmark<LockedWorkQueue>(mode, writers, readers);
+                } else {
+                    result = runBenchmark(mode, writers, readers);
+                }
+                printBenchCsvRow(out, result);
+                out.flush();
+                if (mode == CounterMode::AdaptiveMutex) {
+                    cerr << "adaptive_mutex " << writers << "w/" << readers << "r: ";
+                    printAdaptiveMutexStats(cerr, counterAdaptiveMutex.stats());
+                }
+            }
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
     try {
-        int writerCount, readerCount;
+        parseOptions(argc, argv);
+        if (options.seeded) {
+            setMasterSeed(options.seed);
+        }
+        LatencyRecorder::instance().setEnabled(!options.latencyJson.empty());
+        LatencyRecorder::instance().setSampleInterval(options.latencySample);
+        if (!options.latencyJson.empty()) {
+            LatencyRecorder::instance().dumpJsonAtExit(options.latencyJson);
+        }
+
+        if (options.bench) {
+            if (options.csvPath.empty()) {
+                runBenchmarks(cout);
+            } else {
+                ofstream csv(options.csvPath);
+                if (!csv) {
+                    throw invalid_argument("Cannot open " + options.csvPath);
+                }
+                runBenchmarks(csv);
+            }
+            return 0;
+        }
+
+        int writerCount = options.writerCounts.empty() ? -1 : options.writerCounts.front();
+        int readerCount = options.readerCounts.empty() ? -1 : options.readerCounts.front();
 
         // Get number of writer threads
-        cout << "Enter number of writer threads (N): ";
-        cin >> writerCount;
-        if (cin.fail() || writerCount < 0) {
-            throw invalid_argument("Invalid input. Please enter positive integers.");
+        if (writerCount < 0) {
+            cout << "Enter number of writer threads (N): ";
+            cin >> writerCount;
+            if (cin.fail() || writerCount < 0) {
+                throw invalid_argument("Invalid input. Please enter positive integers.");
+            }
         }
 
         // Get number of reader threads
-        cout << "Enter number of reader threads (M): ";
-        cin >> readerCount;
-        if (cin.fail() || readerCount < 0) {
-            throw invalid_argument("Invalid input. Please enter positive integers.");
+        if (readerCount < 0) {
+            cout << "Enter number of reader threads (M): ";
+            cin >> readerCount;
+            if (cin.fail() || readerCount < 0) {
+                throw invalid_argument("Invalid input. Please enter positive integers.");
+            }
         }
 
+        resetShards(writerCount);
+        AsyncLogger::instance().setBinary(options.logBinary);
+        AsyncLogger::instance().setDropWhenFull(options.logDrop);
+        cout.flush();
+
         // Use vectors for automatic memory management
         vector<thread> writerThreads;
         vector<thread> readerThreads;
-        
+
         writerThreads.reserve(writerCount);
         readerThreads.reserve(readerCount);
 
         // Create writer threads
         for (int i = 0; i < writerCount; ++i) {
             writerThreads.emplace_back(writerThread, i);
+            options.placement.pinThread(writerThreads.back(), i);
         }
 
         // Create reader threads
         for (int i = 0; i < readerCount; ++i) {
             readerThreads.emplace_back(readerThread, i);
+            options.placement.pinThread(readerThreads.back(), writerCount + i);
         }
 
+        auto start = std::chrono::steady_clock::now();
+        startSignal.store(true, std::memory_order_release);
+
         // Wait for all writer threads to complete
         for (auto& thread : writerThreads) {
             if (thread.joinable()) {
                 thread.join();
             }
         }
+        auto writersDone = std::chrono::steady_clock::now();
 
         // Wait for all reader threads to complete
         for (auto& thread : readerThreads) {
@@ -121,6 +731,41 @@ int main() {
                 thread.join();
             }
         }
+        auto readersDone = std::chrono::steady_clock::now();
+        AsyncLogger& logger = AsyncLogger::instance();
+        logger.flush();
+        AdaptiveMutexStats lockStats = counterAdaptiveMutex.stats();  // before readCounter()
+
+        double elapsedMs = std::chrono::duration<double, std::milli>(writersDone - start).count();
+        double readElapsedMs = std::chrono::duration<double, std::milli>(readersDone - start).count();
+        long totalIncrements = options.incrementsPerWriter * writerCount;
+        long totalReads = options.readsPerReader * readerCount;
+        cout << "Mode: " << modeName(options.mode) << ", final counter value: "
+             << readCounter() << " (expected " << totalIncrements << ")\n";
+        if (options.placement.enabled()) {
+            cout << "Placement: " << options.placement.describe(writerCount + readerCount) << "\n";
+        }
+        if (!options.sleep && elapsedMs > 0) {
+            cout << "Writers: " << writerCount << ", " << totalIncrements << " increments in "
+                 << elapsedMs << " ms (" << totalIncrements / elapsedMs / 1000.0
+                 << " M increments/s)\n";
+        }
+        if (!options.sleep && readerCount > 0 && readElapsedMs > 0) {
+            cout << "Readers: " << readerCount << ", " << totalReads << " reads in "
+                 << readElapsedMs << " ms (" << totalReads / readElapsedMs / 1000.0
+                 << " M reads/s)\n";
+        }
+        if (options.mode == CounterMode::AdaptiveMutex) {
+            cout << "Lock: ";
+            printAdaptiveMutexStats(cout, lockStats);
+        }
+
+        if (options.logStats) {
+            AsyncLogger::Stats logStats = logger.stats();
+            cout << "Logger: " << logStats.lines << " lines, " << logStats.dropped << " dropped, "
+                 << "max queue depth " << logStats.maxQueueDepth << ", "
+                 << logStats.writeCalls << " write() calls\n";
+        }
 
         cout << "Execution completed.\n";
 
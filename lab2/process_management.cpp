@@ -1,7 +1,14 @@
 #include <iostream>
-#include <random>
+#include <fstream>
 #include <chrono>
 #include <thread>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <sstream>
+#include <atomic>
+#include "benchmark.h"
+#include "../common/rng.h"
 
 // Platform detection
 #ifdef _WIN32
@@ -10,16 +17,39 @@
 #else
     #include <unistd.h>
     #include <sys/wait.h>
+    #include <sys/mman.h>
     #include <cstdlib>
-    #include <ctime>
+    #include <algorithm>
+    #include "process_pool.h"
     #define PLATFORM_UNIX
 #endif
 
 using std::cerr;
 using std::cin;
 using std::cout;
+using std::ofstream;
+using std::ostream;
+using std::string;
+using std::vector;
 
 constexpr int MAX_SLEEP_MS = 2000;
+constexpr size_t CACHE_LINE_SIZE = 64;
+
+// Command line configuration; empty counts are asked for on stdin
+struct Options {
+    vector<int> writerCounts;
+    vector<int> readerCounts;
+    vector<string> counterModes{"private"};
+    long incrementsPerWriter = 1;
+    int preforkWorkers = 0;
+    long taskCount = 1000000;
+    bool sleep = true;
+    bool bench = false;
+    bool seeded = false;
+    uint64_t seed = 0;
+    BenchConfig benchConfig;
+    string csvPath;
+};
 
 // Shared variable (behavior differs by platform)
 int sharedCounter = 0;
@@ -35,10 +65,8 @@ std::mutex counterMutex;
 void writerProcess(int id) {
     cout << "Writer process " << id << " started (Windows thread)\n";
 
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<> dist(0, MAX_SLEEP_MS);
-    int sleepTime = dist(gen);
+    seedThreadRng(2 * static_cast<uint64_t>(id));
+    int sleepTime = threadRng().uniformInt(0, MAX_SLEEP_MS);
     
     std::this_thread::sleep_for(std::chrono::milliseconds(sleepTime));
 
@@ -53,10 +81,8 @@ void writerProcess(int id) {
 void readerProcess(int id) {
     cout << "Reader process " << id << " started (Windows thread)\n";
 
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<> dist(0, MAX_SLEEP_MS);
-    int sleepTime = dist(gen);
+    seedThreadRng(2 * static_cast<uint64_t>(id) + 1);
+    int sleepTime = threadRng().uniformInt(0, MAX_SLEEP_MS);
     
     std::this_thread::sleep_for(std::chrono::milliseconds(sleepTime));
 
@@ -66,7 +92,7 @@ void readerProcess(int id) {
     }
 }
 
-int runProcessManagement(int writerCount, int readerCount) {
+int runProcessManagement(int writerCount, int readerCount, const Options&) {
     cout << "\n=== Running on Windows (using threads) ===\n\n";
     
     std::vector<std::thread> threads;
@@ -90,41 +116,157 @@ int runProcessManagement(int writerCount, int readerCount) {
     return 0;
 }
 
+int runProcessBenchmarks(const Options&, ostream&) {
+    cerr << "Benchmark mode is only available on Unix (fork)\n";
+    return 1;
+}
+
+int runPreforkedPool(const Options&) {
+    cerr << "The pre-forked pool is only available on Unix (fork)\n";
+    return 1;
+}
+
 #else
 
 // Unix/Linux implementation using fork()
-void writerProcess(int id) {
+
+// Where forked writers put their increments
+enum class CounterMode {
+    Private,  // sharedCounter: every child increments its own copy-on-write copy
+    Atomic,   // one lock-free atomic in a MAP_SHARED region
+    Sharded   // one cache-line padded slot per writer in a MAP_SHARED region
+};
+
+struct alignas(CACHE_LINE_SIZE) SharedSlot {
+    std::atomic<long> value{0};
+};
+
+static_assert(std::atomic<long>::is_always_lock_free,
+              "process-shared counters need a lock-free atomic");
+
+CounterMode counterMode = CounterMode::Private;
+
+// MAP_SHARED regions set up by the parent before forking
+SharedSlot* sharedAtomic = nullptr;
+SharedSlot* sharedShards = nullptr;
+int sharedShardCount = 0;
+
+CounterMode parseCounterMode(const string& name) {
+    if (name == "private") return CounterMode::Private;
+    if (name == "atomic") return CounterMode::Atomic;
+    if (name == "sharded") return CounterMode::Sharded;
+    throw std::invalid_argument("Unknown counter mode: " + name);
+}
+
+// Maps anonymous memory that stays shared with forked children
+void* mapShared(size_t bytes) {
+    void* memory = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    return memory == MAP_FAILED ? nullptr : memory;
+}
+
+// Maps the process-shared counters for the given number of writers
+bool setupSharedCounters(int writerCount) {
+    sharedCounter = 0;
+    sharedShardCount = writerCount > 0 ? writerCount : 1;
+    sharedAtomic = static_cast<SharedSlot*>(mapShared(sizeof(SharedSlot)));
+    sharedShards = static_cast<SharedSlot*>(mapShared(sizeof(SharedSlot) * sharedShardCount));
+    if (sharedAtomic == nullptr || sharedShards == nullptr) {
+        cerr << "Error mapping shared memory\n";
+        return false;
+    }
+
+    new (sharedAtomic) SharedSlot();
+    for (int i = 0; i < sharedShardCount; ++i) {
+        new (&sharedShards[i]) SharedSlot();
+    }
+    return true;
+}
+
+void releaseSharedCounters() {
+    munmap(sharedAtomic, sizeof(SharedSlot));
+    munmap(sharedShards, sizeof(SharedSlot) * sharedShardCount);
+    sharedAtomic = nullptr;
+    sharedShards = nullptr;
+}
+
+void incrementCounter(int writerId) {
+    switch (counterMode) {
+        case CounterMode::Private:
+            ++sharedCounter;
+            break;
+        case CounterMode::Atomic:
+            sharedAtomic->value.fetch_add(1, std::memory_order_relaxed);
+            break;
+        case CounterMode::Sharded: {
+            // Only this writer process updates its slot
+            std::atomic<long>& slot = sharedShards[writerId].value;
+            slot.store(slot.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            break;
+        }
+    }
+}
+
+long readCounter() {
+    switch (counterMode) {
+        case CounterMode::Private:
+            return sharedCounter;
+        case CounterMode::Atomic:
+            return sharedAtomic->value.load(std::memory_order_relaxed);
+        case CounterMode::Sharded: {
+            long total = 0;
+            for (int i = 0; i < sharedShardCount; ++i) {
+                total += sharedShards[i].value.load(std::memory_order_relaxed);
+            }
+            return total;
+        }
+    }
+    return 0;
+}
+
+void writerProcess(int id, const Options& options) {
     cout << "Writer process " << id << " started (Unix fork)\n";
 
-    int sleepTime = rand() % (MAX_SLEEP_MS + 1);
-    usleep(sleepTime * 1000);
+    // The child inherited the parent's generator; give it its own stream
+    if (options.sleep) {
+        seedThreadRng(2 * static_cast<uint64_t>(id));
+        usleep(threadRng().uniformInt(0, MAX_SLEEP_MS) * 1000);
+    }
+
+    for (long i = 0; i < options.incrementsPerWriter; ++i) {
+        incrementCounter(id);
+    }
 
-    ++sharedCounter;
-    
     exit(0);
 }
 
-void readerProcess(int id) {
+void readerProcess(int id, const Options& options) {
     cout << "Reader process " << id << " started (Unix fork)\n";
 
-    int sleepTime = rand() % (MAX_SLEEP_MS + 1);
-    usleep(sleepTime * 1000);
+    if (options.sleep) {
+        seedThreadRng(2 * static_cast<uint64_t>(id) + 1);
+        usleep(threadRng().uniformInt(0, MAX_SLEEP_MS) * 1000);
+    }
+
+    cout << "Reader process " << id << " - Counter value: " << readCounter() << "\n";
 
-    cout << "Reader process " << id << " - Counter value: " << sharedCounter << "\n";
-    
     exit(0);
 }
 
-int runProcessManagement(int writerCount, int readerCount) {
+int runProcessManagement(int writerCount, int readerCount, const Options& options) {
     cout << "\n=== Running on Unix/Linux (using fork) ===\n\n";
-    
-    srand(static_cast<unsigned int>(time(nullptr)));
+
+    counterMode = parseCounterMode(options.counterModes.front());
+    if (!setupSharedCounters(writerCount)) {
+        return 1;
+    }
+    cout.flush();
+    auto start = std::chrono::steady_clock::now();
 
     // Create writer processes
     for (int i = 0; i < writerCount; ++i) {
         pid_t pid = fork();
         if (pid == 0) {
-            writerProcess(i);
+            writerProcess(i, options);
         } else if (pid < 0) {
             cerr << "Error creating writer process " << i << "\n";
         }
@@ -134,7 +276,7 @@ int runProcessManagement(int writerCount, int readerCount) {
     for (int i = 0; i < readerCount; ++i) {
         pid_t pid = fork();
         if (pid == 0) {
-            readerProcess(i);
+            readerProcess(i, options);
         } else if (pid < 0) {
             cerr << "Error creating reader process " << i << "\n";
         }
@@ -143,15 +285,285 @@ int runProcessManagement(int writerCount, int readerCount) {
     // Wait for all child processes
     int status;
     while (wait(&status) > 0);
+    double elapsedMs = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+
+    // Private increments stayed in the children, shared ones are summed here
+    long totalIncrements = options.incrementsPerWriter * writerCount;
+    cout << "\nCounter mode: " << options.counterModes.front() << ", final value: "
+         << readCounter() << " (expected " << totalIncrements << ")\n";
+    if (!options.sleep && elapsedMs > 0) {
+        cout << "Writers: " << writerCount << ", " << totalIncrements << " increments in "
+             << elapsedMs << " ms including fork (" << totalIncrements / elapsedMs / 1000.0
+             << " M increments/s)\n";
+    }
+    releaseSharedCounters();
 
     cout << "\nExecution completed.\n";
     return 0;
 }
 
+// Forks one child per task, as runProcessManagement does, to give the
+// pre-forked pool a baseline
+double measureForkPerTask(long taskCount) {
+    if (!setupSharedCounters(1)) {
+        return 0;
+    }
+    counterMode = CounterMode::Atomic;
+    cout.flush();
+
+    auto start = std::chrono::steady_clock::now();
+    for (long i = 0; i < taskCount; ++i) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            incrementCounter(0);
+            _exit(0);
+        } else if (pid < 0) {
+            cerr << "Error creating baseline process " << i << "\n";
+            taskCount = i;
+            break;
+        }
+        waitpid(pid, nullptr, 0);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    releaseSharedCounters();
+    return seconds > 0 ? taskCount / seconds : 0;
+}
+
+// Pushes taskCount small tasks (alternating increments and reads of a
+// shared counter) through a pool of pre-forked workers
+int runPreforkedPool(const Options& options) {
+    constexpr long BASELINE_TASKS = 1000;
+    cout << "\n=== Pre-forked pool: " << options.preforkWorkers << " workers, "
+         << options.taskCount << " tasks ===\n\n";
+    cout.flush();
+
+    try {
+        ProcessPool pool(options.preforkWorkers);
+        long increments = 0;
+        long reads = 0;
+
+        auto start = std::chrono::steady_clock::now();
+        pool.run(static_cast<uint64_t>(options.taskCount),
+                 [](uint64_t index) {
+                     uint32_t type = index % 2 == 0 ? POOL_TASK_INCREMENT : POOL_TASK_READ;
+                     return PoolTask{index, type, 1};
+                 },
+                 [&](const PoolResult& result) {
+                     if (result.taskId % 2 == 0) {
+                         ++increments;
+                     } else {
+                         ++reads;
+                     }
+                 });
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        pool.shutdown();
+
+        ProcessPool::Stats stats = pool.stats();
+        cout << "Counter value: " << pool.counterValue() << " (expected " << increments << "), "
+             << reads << " reads\n";
+        cout << "Pool: " << options.taskCount / seconds << " tasks/s ("
+             << seconds * 1e9 / options.taskCount << " ns per task)\n";
+        cout << "Worker futex sleeps: " << stats.workerSleeps
+             << ", parent sleeps: " << stats.parentSleeps << "\n";
+        cout << "Tasks per worker:";
+        for (uint64_t tasks : stats.tasksPerWorker) {
+            cout << " " << tasks;
+        }
+        cout << "\n";
+    } catch (const std::exception& e) {
+        cerr << "Error running pool: " << e.what() << "\n";
+        return 1;
+    }
+
+    long baselineTasks = std::min(options.taskCount, BASELINE_TASKS);
+    cout << "Fork per task (" << baselineTasks << " tasks): "
+         << measureForkPerTask(baselineTasks) << " tasks/s\n";
+    return 0;
+}
+
+// Forks writer and reader children that loop on their operation through the
+// warmup and measurement phases. Phase and per-child samples live in shared
+// memory, so results come back without pipes.
+bool runProcessBenchmark(const BenchConfig& config, int writerCount, int readerCount,
+                         BenchResult& result) {
+    int childCount = writerCount + readerCount;
+    size_t samplesBytes = sizeof(BenchSample) * childCount;
+    auto* phase = static_cast<std::atomic<int>*>(mapShared(sizeof(std::atomic<int>)));
+    auto* samples = static_cast<BenchSample*>(mapShared(samplesBytes));
+    if (phase == nullptr || samples == nullptr) {
+        cerr << "Error mapping shared memory\n";
+        return false;
+    }
+
+    new (phase) std::atomic<int>(BENCH_WARMUP);
+    for (int i = 0; i < childCount; ++i) {
+        new (&samples[i]) BenchSample();
+    }
+
+    cout.flush();
+    int started = 0;
+    for (int i = 0; i < childCount; ++i) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            long lastValue = 0;
+            if (i < writerCount) {
+                runBenchLoop(*phase, samples[i], [i]() { incrementCounter(i); });
+            } else {
+                runBenchLoop(*phase, samples[i], [&]() { lastValue = readCounter(); });
+            }
+            _exit(0);
+        } else if (pid < 0) {
+            cerr << "Error creating benchmark process " << i << "\n";
+            break;
+        }
+        ++started;
+    }
+
+    result.writers = writerCount;
+    result.readers = readerCount;
+    result.seconds = runBenchPhases(config, *phase);
+
+    int status;
+    while (wait(&status) > 0);
+
+    for (int i = 0; i < started; ++i) {
+        BenchSample& target = i < writerCount ? result.writes : result.reads;
+        target.operations += samples[i].operations;
+        target.latency.merge(samples[i].latency);
+    }
+
+    munmap(phase, sizeof(std::atomic<int>));
+    munmap(samples, samplesBytes);
+    return started == childCount;
+}
+
+int runProcessBenchmarks(const Options& options, ostream& out) {
+    vector<int> writerCounts = options.writerCounts.empty() ? vector<int>{1} : options.writerCounts;
+    vector<int> readerCounts = options.readerCounts.empty() ? vector<int>{0} : options.readerCounts;
+
+    printBenchCsvHeader(out);
+    for (const string& mode : options.counterModes) {
+        counterMode = parseCounterMode(mode);
+        for (int writers : writerCounts) {
+            for (int readers : readerCounts) {
+                if (writers + readers == 0) {
+                    continue;
+                }
+                if (!setupSharedCounters(writers)) {
+                    return 1;
+                }
+                BenchResult result;
+                result.mode = mode;
+                bool completed = runProcessBenchmark(options.benchConfig, writers, readers, result);
+                releaseSharedCounters();
+                if (!completed) {
+                    return 1;
+                }
+                printBenchCsvRow(out, result);
+                out.flush();
+            }
+        }
+    }
+    return 0;
+}
+
 #endif
 
-int main() {
-    int writerCount, readerCount;
+void printUsage() {
+    cerr << "Usage: process_management [--writers N] [--readers M]\n"
+         << "       [--counter private|atomic|sharded] [--increments K] [--no-sleep] [--seed S]\n"
+         << "       process_management --prefork WORKERS [--tasks N]\n"
+         << "       process_management --bench [--counter LIST] [--writers LIST] [--readers LIST]\n"
+         << "       [--warmup-ms MS] [--duration-ms MS] [--csv PATH]\n";
+}
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (arg == "--writers" && hasValue) {
+            options.writerCounts = parseCountList(argv[++i]);
+        } else if (arg == "--readers" && hasValue) {
+            options.readerCounts = parseCountList(argv[++i]);
+        } else if (arg == "--counter" && hasValue) {
+            options.counterModes.clear();
+            std::stringstream modes(argv[++i]);
+            string mode;
+            while (std::getline(modes, mode, ',')) {
+                if (mode != "private" && mode != "atomic" && mode != "sharded") {
+                    return false;
+                }
+                options.counterModes.push_back(mode);
+            }
+        } else if (arg == "--increments" && hasValue) {
+            options.incrementsPerWriter = std::stol(argv[++i]);
+        } else if (arg == "--seed" && hasValue) {
+            options.seed = std::stoull(argv[++i]);
+            options.seeded = true;
+        } else if (arg == "--no-sleep") {
+            options.sleep = false;
+        } else if (arg == "--prefork" && hasValue) {
+            options.preforkWorkers = std::stoi(argv[++i]);
+        } else if (arg == "--tasks" && hasValue) {
+            options.taskCount = std::stol(argv[++i]);
+        } else if (arg == "--bench") {
+            options.bench = true;
+        } else if (arg == "--warmup-ms" && hasValue) {
+            options.benchConfig.warmupMs = std::stoi(argv[++i]);
+        } else if (arg == "--duration-ms" && hasValue) {
+            options.benchConfig.durationMs = std::stoi(argv[++i]);
+        } else if (arg == "--csv" && hasValue) {
+            options.csvPath = argv[++i];
+        } else {
+            return false;
+        }
+    }
+    if (options.counterModes.empty() || options.incrementsPerWriter < 0 ||
+        options.preforkWorkers < 0 || options.taskCount < 1) {
+        return false;
+    }
+    return options.bench || (options.writerCounts.size() <= 1 && options.readerCounts.size() <= 1 &&
+                             options.counterModes.size() == 1);
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    try {
+        if (!parseOptions(argc, argv, options)) {
+            printUsage();
+            return 1;
+        }
+    } catch (const std::exception& e) {
+        cerr << e.what() << "\n";
+        printUsage();
+        return 1;
+    }
+
+    if (options.seeded) {
+        setMasterSeed(options.seed);
+    }
+
+    if (options.preforkWorkers > 0) {
+        return runPreforkedPool(options);
+    }
+
+    if (options.bench) {
+        if (options.csvPath.empty()) {
+            return runProcessBenchmarks(options, cout);
+        }
+        ofstream csv(options.csvPath);
+        if (!csv) {
+            cerr << "Cannot open " << options.csvPath << "\n";
+            return 1;
+        }
+        return runProcessBenchmarks(options, csv);
+    }
+
+    int writerCount = options.writerCounts.empty() ? -1 : options.writerCounts.front();
+    int readerCount = options.readerCounts.empty() ? -1 : options.readerCounts.front();
 
     cout << "=== Cross-Platform Process Management Demo ===\n";
     
@@ -161,19 +573,23 @@ int main() {
     cout << "Detected: Unix/Linux\n";
     #endif
 
-    cout << "\nEnter number of writer processes (N): ";
-    cin >> writerCount;
-    if (cin.fail() || writerCount < 0) {
-        cerr << "Invalid input\n";
-        return 1;
+    if (writerCount < 0) {
+        cout << "\nEnter number of writer processes (N): ";
+        cin >> writerCount;
+        if (cin.fail() || writerCount < 0) {
+            cerr << "Invalid input\n";
+            return 1;
+        }
     }
 
-    cout << "Enter number of reader processes (M): ";
-    cin >> readerCount;
-    if (cin.fail() || readerCount < 0) {
-        cerr << "Invalid input\n";
-        return 1;
+    if (readerCount < 0) {
+        cout << "Enter number of reader processes (M): ";
+        cin >> readerCount;
+        if (cin.fail() || readerCount < 0) {
+            cerr << "Invalid input\n";
+            return 1;
+        }
     }
 
-    return runProcessManagement(writerCount, readerCount);
+    return runProcessManagement(writerCount, readerCount, options);
 }
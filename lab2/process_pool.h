@@ -0,0 +1,250 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include "../common/futex.h"
+#include "../common/mpmc_ring.h"
+
+// Pre-forked pool of worker processes. Tasks and results travel through two
+// lock-free rings in one MAP_SHARED region, so submitting a task costs no
+// fork and no syscall unless a worker is asleep. Idle workers spin briefly,
+// then block on a process-shared futex until the parent queues more work.
+
+enum PoolTaskType : uint32_t {
+    POOL_TASK_INCREMENT = 0,  // add the argument to the shared counter
+    POOL_TASK_READ = 1        // return the shared counter
+};
+
+struct PoolTask {
+    uint64_t id;
+    uint32_t type;
+    int64_t argument;
+};
+
+struct PoolResult {
+    uint64_t taskId;
+    int64_t value;
+    uint32_t worker;
+};
+
+class ProcessPool {
+public:
+    static constexpr size_t QUEUE_CAPACITY = 4096;
+    static constexpr int MAX_WORKERS = 256;
+    static constexpr int SPIN_LIMIT = 2000;
+
+    struct Stats {
+        uint64_t workerSleeps = 0;
+        uint64_t parentSleeps = 0;
+        std::vector<uint64_t> tasksPerWorker;
+    };
+
+private:
+    struct alignas(64) WorkerSlot {
+        std::atomic<uint64_t> tasks{0};
+        std::atomic<uint64_t> sleeps{0};
+    };
+
+    struct SharedState {
+        MpmcRing<PoolTask, QUEUE_CAPACITY> tasks;
+        MpmcRing<PoolResult, QUEUE_CAPACITY> results;
+        alignas(64) std::atomic<uint32_t> taskSignal{0};
+        std::atomic<uint32_t> idleWorkers{0};
+        alignas(64) std::atomic<uint32_t> resultSignal{0};
+        std::atomic<uint32_t> parentWaiting{0};
+        alignas(64) std::atomic<uint32_t> stopping{0};
+        alignas(64) std::atomic<int64_t> counter{0};
+        WorkerSlot workers[MAX_WORKERS];
+    };
+
+    SharedState* shared_ = nullptr;
+    std::vector<pid_t> workers_;
+    int workerCount_ = 0;
+    uint64_t parentSleeps_ = 0;
+
+    PoolResult execute(const PoolTask& task, uint32_t worker) {
+        PoolResult result{task.id, 0, worker};
+        switch (task.type) {
+            case POOL_TASK_INCREMENT:
+                result.value = shared_->counter.fetch_add(task.argument) + task.argument;
+                break;
+            case POOL_TASK_READ:
+                result.value = shared_->counter.load(std::memory_order_relaxed);
+                break;
+        }
+        return result;
+    }
+
+    void publishResult(const PoolResult& result) {
+        while (!shared_->results.tryPush(result)) {
+            std::this_thread::yield();
+        }
+        shared_->resultSignal.fetch_add(1);
+        if (shared_->parentWaiting.load() != 0) {
+            futexWake(&shared_->resultSignal, 1, true);
+        }
+    }
+
+    [[noreturn]] void workerMain(uint32_t worker) {
+        WorkerSlot& slot = shared_->workers[worker];
+        PoolTask task;
+        int spins = 0;
+
+        while (true) {
+            if (shared_->tasks.tryPop(task)) {
+                publishResult(execute(task, worker));
+                slot.tasks.fetch_add(1, std::memory_order_relaxed);
+                spins = 0;
+                continue;
+            }
+            if (++spins < SPIN_LIMIT) {
+                continue;
+            }
+
+            // Read the signal before announcing ourselves idle: a submit that
+            // lands after this point changes the word and the wait returns
+            uint32_t signal = shared_->taskSignal.load();
+            shared_->idleWorkers.fetch_add(1);
+            if (shared_->tasks.tryPop(task)) {
+                shared_->idleWorkers.fetch_sub(1);
+                publishResult(execute(task, worker));
+                slot.tasks.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+            if (shared_->stopping.load() != 0) {
+                _exit(0);
+            }
+            slot.sleeps.fetch_add(1, std::memory_order_relaxed);
+            futexWait(&shared_->taskSignal, signal, true);
+            shared_->idleWorkers.fetch_sub(1);
+            spins = 0;
+        }
+    }
+
+    // Destroys and unmaps the shared state; only once no worker is left
+    void releaseShared() {
+        shared_->~SharedState();
+        munmap(shared_, sizeof(SharedState));
+    }
+
+    void waitForResults(uint32_t signal) {
+        shared_->parentWaiting.store(1);
+        if (shared_->results.size() == 0) {
+            ++parentSleeps_;
+            futexWait(&shared_->resultSignal, signal, true);
+        }
+        shared_->parentWaiting.store(0);
+    }
+
+public:
+    explicit ProcessPool(int workerCount) {
+        if (workerCount < 1 || workerCount > MAX_WORKERS) {
+            throw std::invalid_argument("worker count out of range");
+        }
+
+        void* memory = mmap(nullptr, sizeof(SharedState), PROT_READ | PROT_WRITE,
+                            MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED) {
+            throw std::runtime_error("cannot map shared pool state");
+        }
+        shared_ = new (memory) SharedState();
+
+        for (int i = 0; i < workerCount; ++i) {
+            pid_t pid = fork();
+            if (pid == 0) {
+                workerMain(static_cast<uint32_t>(i));
+            } else if (pid < 0) {
+                shutdown();
+                releaseShared();  // the destructor does not run for a throwing constructor
+                throw std::runtime_error("cannot fork pool worker");
+            }
+            workers_.push_back(pid);
+            ++workerCount_;
+        }
+    }
+
+    ProcessPool(const ProcessPool&) = delete;
+    ProcessPool& operator=(const ProcessPool&) = delete;
+
+    ~ProcessPool() {
+        shutdown();
+        releaseShared();
+    }
+
+    // Queues a task without blocking; false when the task ring is full
+    bool trySubmit(const PoolTask& task) {
+        if (!shared_->tasks.tryPush(task)) {
+            return false;
+        }
+        shared_->taskSignal.fetch_add(1);
+        if (shared_->idleWorkers.load() != 0) {
+            futexWake(&shared_->taskSignal, 1, true);
+        }
+        return true;
+    }
+
+    bool tryCollect(PoolResult& result) {
+        return shared_->results.tryPop(result);
+    }
+
+    // Submits taskCount tasks built by makeTask(index) and hands every result
+    // to onResult, draining results whenever the task ring fills up
+    template <typename MakeTask, typename OnResult>
+    void run(uint64_t taskCount, MakeTask makeTask, OnResult onResult) {
+        uint64_t submitted = 0;
+        uint64_t collected = 0;
+        PoolResult result;
+
+        while (collected < taskCount) {
+            while (submitted < taskCount && trySubmit(makeTask(submitted))) {
+                ++submitted;
+            }
+
+            uint32_t signal = shared_->resultSignal.load();
+            bool progressed = false;
+            while (tryCollect(result)) {
+                onResult(result);
+                ++collected;
+                progressed = true;
+            }
+            if (!progressed && collected < taskCount) {
+                waitForResults(signal);
+            }
+        }
+    }
+
+    // Stops the workers once the task ring has drained and reaps them
+    void shutdown() {
+        if (workers_.empty()) {
+            return;
+        }
+        shared_->stopping.store(1);
+        shared_->taskSignal.fetch_add(1);
+        futexWakeAll(&shared_->taskSignal, true);
+        for (pid_t pid : workers_) {
+            waitpid(pid, nullptr, 0);
+        }
+        workers_.clear();
+    }
+
+    int64_t counterValue() const {
+        return shared_->counter.load();
+    }
+
+    Stats stats() const {
+        Stats stats;
+        stats.parentSleeps = parentSleeps_;
+        for (int i = 0; i < workerCount_; ++i) {
+            stats.tasksPerWorker.push_back(shared_->workers[i].tasks.load());
+            stats.workerSleeps += shared_->workers[i].sleeps.load();
+        }
+        return stats;
+    }
+};
@@ -0,0 +1,255 @@
+#include <iostream>
+#include <fstream>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <sstream>
+#include <stdexcept>
+#include <cstdint>
+#include <memory>
+#include "benchmark.h"
+#include "../common/latency_histogram.h"
+
+#ifdef _WIN32
+    #define PLATFORM_WINDOWS
+#else
+    #define PLATFORM_UNIX
+    #include <sys/mman.h>
+    #include <sys/wait.h>
+    #include <unistd.h>
+    #include "../common/memory_usage.h"
+    #include "../common/process_spawn.h"
+#endif
+
+using std::cerr;
+using std::cout;
+using std::ofstream;
+using std::ostream;
+using std::string;
+using std::vector;
+
+// How long does it take to start a child process, and how does that change
+// as the parent grows? For every parent heap size this maps and touches that
+// much memory, then starts --children children one after another with each
+// spawn method and reports children/sec plus two latencies:
+//   spawn   time the parent spends inside the spawn call
+//   exit    time from the spawn call until waitpid() reaps the child
+// Each child runs --exec (default /bin/true), except with fork_noexec.
+
+#ifdef PLATFORM_WINDOWS
+
+int main() {
+    cerr << "The process spawn benchmark is only available on Unix\n";
+    return 1;
+}
+
+#else
+
+constexpr size_t MEGABYTE = 1024 * 1024;
+
+struct Options {
+    vector<int> heapMb{10, 1024, 8192};
+    vector<SpawnMethod> methods = availableSpawnMethods();
+    long children = 200;
+    bool writeHeap = true;  // false only reads it: no RSS, no page tables to copy
+    string program = "/bin/true";
+    string csvPath;
+};
+
+// Anonymous memory standing in for a parent's heap, touched once per page
+class ParentHeap {
+private:
+    void* memory_ = nullptr;
+    size_t bytes_ = 0;
+
+public:
+    ParentHeap(size_t bytes, bool write) : bytes_(bytes) {
+        // A read-only heap never becomes resident, so it need not be reserved
+        int flags = MAP_PRIVATE | MAP_ANONYMOUS | (write ? 0 : MAP_NORESERVE);
+        memory_ = mmap(nullptr, bytes_, PROT_READ | PROT_WRITE, flags, -1, 0);
+        if (memory_ == MAP_FAILED) {
+            memory_ = nullptr;
+            throw std::runtime_error("cannot map " + std::to_string(bytes_ / MEGABYTE) + " MB");
+        }
+#ifdef MADV_NOHUGEPAGE
+        // 4 KB pages, as a malloc heap usually gets: one page table entry each
+        madvise(memory_, bytes_, MADV_NOHUGEPAGE);
+#endif
+        size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        volatile char* bytesPtr = static_cast<volatile char*>(memory_);
+        char sink = 0;
+        for (size_t offset = 0; offset < bytes_; offset += page) {
+            if (write) {
+                bytesPtr[offset] = 1;
+            } else {
+                sink ^= bytesPtr[offset];
+            }
+        }
+        (void)sink;
+    }
+
+    ParentHeap(const ParentHeap&) = delete;
+    ParentHeap& operator=(const ParentHeap&) = delete;
+
+    ~ParentHeap() {
+        if (memory_ != nullptr) {
+            munmap(memory_, bytes_);
+        }
+    }
+};
+
+struct SpawnResult {
+    long children = 0;
+    double seconds = 0;
+    LatencyHistogram spawn;
+    LatencyHistogram exit;
+};
+
+uint64_t nanosecondsBetween(std::chrono::steady_clock::time_point start,
+                            std::chrono::steady_clock::time_point end) {
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+}
+
+// Starts and reaps children one at a time; throws if a child cannot be started
+// or does not exit cleanly (for example because --exec does not exist)
+SpawnResult runSpawns(SpawnMethod method, const SpawnCommand& command, long children) {
+    using Clock = std::chrono::steady_clock;
+    ProcessSpawner spawner(method);
+    SpawnResult result;
+
+    auto first = Clock::now();
+    for (long i = 0; i < children; ++i) {
+        auto start = Clock::now();
+        pid_t pid = spawner.spawn(command);
+        auto spawned = Clock::now();
+        int status = 0;
+        waitpid(pid, &status, 0);
+        auto exited = Clock::now();
+
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            throw std::runtime_error(string(spawnMethodName(method)) + " child failed (status " +
+                                     std::to_string(status) + ")");
+        }
+        result.spawn.record(nanosecondsBetween(start, spawned));
+        result.exit.record(nanosecondsBetween(start, exited));
+        ++result.children;
+    }
+    result.seconds = std::chrono::duration<double>(Clock::now() - first).count();
+    return result;
+}
+
+// Memory that can still be made resident, so a write-touched heap does not
+// wake the OOM killer
+size_t availableBytes() {
+#ifdef _SC_AVPHYS_PAGES
+    return static_cast<size_t>(sysconf(_SC_AVPHYS_PAGES)) *
+           static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#else
+    return SIZE_MAX;
+#endif
+}
+
+int runBenchmarks(const Options& options, ostream& out) {
+    SpawnCommand command({options.program});
+    out << "heap_mb,heap_touch,parent_rss_mb,method,children,children_per_sec,"
+        << "spawn_p50_ns,spawn_p99_ns,exit_p50_ns,exit_p99_ns\n";
+
+    for (int heapMb : options.heapMb) {
+        size_t bytes = static_cast<size_t>(heapMb) * MEGABYTE;
+        if (options.writeHeap && bytes > availableBytes() / 10 * 9) {
+            cerr << "Skipping " << heapMb << " MB: only " << availableBytes() / MEGABYTE
+                 << " MB available (--heap-touch read maps it without making it resident)\n";
+            continue;
+        }
+        std::unique_ptr<ParentHeap> heap;
+        try {
+            heap = std::make_unique<ParentHeap>(bytes, options.writeHeap);
+        } catch (const std::runtime_error& e) {
+            cerr << "Skipping " << heapMb << " MB: " << e.what() << "\n";
+            continue;
+        }
+        long rssMb = readMemoryUsage().rssKb / 1024;
+
+        for (SpawnMethod method : options.methods) {
+            SpawnResult result = runSpawns(method, command, options.children);
+            out << heapMb << "," << (options.writeHeap ? "write" : "read") << "," << rssMb << ","
+                << spawnMethodName(method) << "," << result.children << ","
+                << static_cast<uint64_t>(result.children / result.seconds) << ","
+                << result.spawn.percentile(50) << "," << result.spawn.percentile(99) << ","
+                << result.exit.percentile(50) << "," << result.exit.percentile(99) << "\n";
+            out.flush();
+        }
+    }
+    return 0;
+}
+
+void printUsage() {
+    cerr << "Usage: process_spawn_benchmark [--heap-mb LIST] [--method LIST] [--children N]\n"
+         << "       [--heap-touch write|read] [--exec PATH] [--csv PATH]\n"
+         << "  methods: fork, fork_noexec, vfork, posix_spawn, clone (Linux)\n";
+}
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (arg == "--heap-mb" && hasValue) {
+            options.heapMb = parseCountList(argv[++i]);
+        } else if (arg == "--method" && hasValue) {
+            options.methods.clear();
+            std::stringstream methods(argv[++i]);
+            string method;
+            while (std::getline(methods, method, ',')) {
+                options.methods.push_back(parseSpawnMethod(method));
+            }
+        } else if (arg == "--children" && hasValue) {
+            options.children = std::stol(argv[++i]);
+        } else if (arg == "--heap-touch" && hasValue) {
+            string touch = argv[++i];
+            if (touch != "write" && touch != "read") {
+                return false;
+            }
+            options.writeHeap = touch == "write";
+        } else if (arg == "--exec" && hasValue) {
+            options.program = argv[++i];
+        } else if (arg == "--csv" && hasValue) {
+            options.csvPath = argv[++i];
+        } else {
+            return false;
+        }
+    }
+    return !options.methods.empty() && options.children > 0;
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    try {
+        if (!parseOptions(argc, argv, options)) {
+            printUsage();
+            return 1;
+        }
+    } catch (const std::exception& e) {
+        cerr << e.what() << "\n";
+        printUsage();
+        return 1;
+    }
+
+    try {
+        if (options.csvPath.empty()) {
+            return runBenchmarks(options, cout);
+        }
+        ofstream csv(options.csvPath);
+        if (!csv) {
+            cerr << "Cannot open " << options.csvPath << "\n";
+            return 1;
+        }
+        return runBenchmarks(options, csv);
+    } catch (const std::exception& e) {
+        cerr << e.what() << "\n";
+        return 1;
+    }
+}
+
+#endif
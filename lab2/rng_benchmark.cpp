@@ -0,0 +1,202 @@
+#include <iostream>
+#include <fstream>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <random>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <stdexcept>
+#include <cstdlib>
+#include <algorithm>
+#include "benchmark.h"
+#include "../common/rng.h"
+
+using std::atomic;
+using std::cerr;
+using std::cout;
+using std::mutex;
+using std::ofstream;
+using std::ostream;
+using std::string;
+using std::thread;
+using std::vector;
+
+// Measures uniform-int draws/sec for the ways the labs used to get random
+// numbers (global rand(), a fresh random_device + mt19937 per call, one
+// generator shared behind a mutex) against the per-thread Xoshiro256 from
+// common/rng.h, one draw at a time and in batches.
+
+constexpr int DRAW_MIN = 0;
+constexpr int DRAW_MAX = 99;
+constexpr size_t BLOCK_SIZE = 256;  // draws between two phase checks
+
+const vector<string> ALL_MODES{"rand", "per_call_mt19937", "shared_mt19937", "local_mt19937",
+                               "xoshiro", "xoshiro_batch"};
+
+struct Options {
+    vector<string> modes = ALL_MODES;
+    vector<int> threadCounts{1, static_cast<int>(std::max(1u, thread::hardware_concurrency()))};
+    BenchConfig benchConfig;
+    string csvPath;
+};
+
+mutex sharedMutex;
+std::mt19937 sharedGenerator(1);
+
+// Fills block with BLOCK_SIZE draws in [DRAW_MIN, DRAW_MAX] using the named method
+void drawBlock(const string& mode, int* block) {
+    if (mode == "rand") {
+        for (size_t i = 0; i < BLOCK_SIZE; ++i) {
+            block[i] = DRAW_MIN + rand() % (DRAW_MAX - DRAW_MIN + 1);
+        }
+    } else if (mode == "per_call_mt19937") {
+        for (size_t i = 0; i < BLOCK_SIZE; ++i) {
+            std::random_device rd;
+            std::mt19937 gen(rd());
+            std::uniform_int_distribution<> dist(DRAW_MIN, DRAW_MAX);
+            block[i] = dist(gen);
+        }
+    } else if (mode == "shared_mt19937") {
+        std::uniform_int_distribution<> dist(DRAW_MIN, DRAW_MAX);
+        for (size_t i = 0; i < BLOCK_SIZE; ++i) {
+            std::lock_guard<mutex> lock(sharedMutex);
+            block[i] = dist(sharedGenerator);
+        }
+    } else if (mode == "local_mt19937") {
+        thread_local std::mt19937 gen(std::random_device{}());
+        std::uniform_int_distribution<> dist(DRAW_MIN, DRAW_MAX);
+        for (size_t i = 0; i < BLOCK_SIZE; ++i) {
+            block[i] = dist(gen);
+        }
+    } else if (mode == "xoshiro") {
+        Xoshiro256& rng = threadRng();
+        for (size_t i = 0; i < BLOCK_SIZE; ++i) {
+            block[i] = rng.uniformInt(DRAW_MIN, DRAW_MAX);
+        }
+    } else {
+        threadRng().fillUniformInt(block, BLOCK_SIZE, DRAW_MIN, DRAW_MAX);
+    }
+}
+
+// Runs one mode on threadCount threads and returns the measured draws/sec
+double runBenchmark(const Options& options, const string& mode, int threadCount) {
+    atomic<int> phase{BENCH_WARMUP};
+    vector<uint64_t> draws(threadCount, 0);
+    vector<thread> threads;
+
+    for (int t = 0; t < threadCount; ++t) {
+        threads.emplace_back([&, t]() {
+            seedThreadRng(static_cast<uint64_t>(t));
+            int block[BLOCK_SIZE];
+            uint64_t counted = 0;
+            uint64_t sink = 0;
+            while (true) {
+                int current = phase.load(std::memory_order_relaxed);
+                if (current == BENCH_STOP) {
+                    break;
+                }
+                drawBlock(mode, block);
+                sink += static_cast<uint64_t>(block[BLOCK_SIZE - 1]);
+                if (current == BENCH_MEASURE) {
+                    counted += BLOCK_SIZE;
+                }
+            }
+            // Keep the draws observable so the loop is not optimized away
+            draws[t] = counted + (sink == UINT64_MAX ? 1 : 0);
+        });
+    }
+
+    double seconds = runBenchPhases(options.benchConfig, phase);
+    for (auto& worker : threads) {
+        worker.join();
+    }
+
+    uint64_t total = 0;
+    for (uint64_t count : draws) {
+        total += count;
+    }
+    return total / seconds;
+}
+
+void runBenchmarks(const Options& options, ostream& out) {
+    out << "mode,threads,draws_per_sec,ns_per_draw_per_thread\n";
+    for (const string& mode : options.modes) {
+        for (int threadCount : options.threadCounts) {
+            double drawsPerSecond = runBenchmark(options, mode, threadCount);
+            out << mode << "," << threadCount << "," << static_cast<uint64_t>(drawsPerSecond) << ","
+                << 1e9 * threadCount / drawsPerSecond << "\n";
+            out.flush();
+        }
+    }
+}
+
+void printUsage() {
+    cerr << "Usage: rng_benchmark [--mode LIST] [--threads LIST] [--warmup-ms MS]\n"
+         << "       [--duration-ms MS] [--seed S] [--csv PATH]\n"
+         << "  modes: rand, per_call_mt19937, shared_mt19937, local_mt19937, xoshiro, xoshiro_batch\n";
+}
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (arg == "--mode" && hasValue) {
+            options.modes.clear();
+            std::stringstream modes(argv[++i]);
+            string mode;
+            while (std::getline(modes, mode, ',')) {
+                if (std::find(ALL_MODES.begin(), ALL_MODES.end(), mode) == ALL_MODES.end()) {
+                    return false;
+                }
+                options.modes.push_back(mode);
+            }
+        } else if (arg == "--threads" && hasValue) {
+            options.threadCounts = parseCountList(argv[++i]);
+        } else if (arg == "--warmup-ms" && hasValue) {
+            options.benchConfig.warmupMs = std::stoi(argv[++i]);
+        } else if (arg == "--duration-ms" && hasValue) {
+            options.benchConfig.durationMs = std::stoi(argv[++i]);
+        } else if (arg == "--seed" && hasValue) {
+            setMasterSeed(std::stoull(argv[++i]));
+        } else if (arg == "--csv" && hasValue) {
+            options.csvPath = argv[++i];
+        } else {
+            return false;
+        }
+    }
+    for (int count : options.threadCounts) {
+        if (count < 1) {
+            return false;
+        }
+    }
+    return !options.modes.empty();
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    try {
+        if (!parseOptions(argc, argv, options)) {
+            printUsage();
+            return 1;
+        }
+    } catch (const std::exception& e) {
+        cerr << e.what() << "\n";
+        printUsage();
+        return 1;
+    }
+
+    if (options.csvPath.empty()) {
+        runBenchmarks(options, cout);
+        return 0;
+    }
+    ofstream csv(options.csvPath);
+    if (!csv) {
+        cerr << "Cannot open " << options.csvPath << "\n";
+        return 1;
+    }
+    runBenchmarks(options, csv);
+    return 0;
+}
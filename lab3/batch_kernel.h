@@ -0,0 +1,324 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include "game_rules.h"
+#include "simulation.h"
+#include "../common/rng.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+    #include <emmintrin.h>
+    #define BATCH_HAVE_SSE2
+#endif
+#ifdef __AVX2__
+    #include <immintrin.h>
+    #define BATCH_HAVE_AVX2
+#endif
+
+// Batched game kernel: plays WIDTH independent games in lockstep, one per
+// SIMD lane. State is struct-of-arrays - one vector per seat holding that
+// seat's score in every lane, plus per-seat active and busted lane masks - so
+// a round is the same few vector instructions for all WIDTH games, and
+// standing/busting is a mask update instead of a branch. A group of lanes
+// runs until its last game ends; finished lanes just stop changing.
+//
+// Each lane owns a xoshiro128+ generator, so card draws are vectorized too.
+// The lane types below provide the handful of operations the kernel needs:
+// AVX2 (8 lanes, build with -mavx2 or -march=native), SSE2 (4 lanes, always
+// on x86-64) and a portable one-lane fallback.
+
+// One game per "vector": plain scalar code, with masks as all-ones words
+struct ScalarLanes {
+    static constexpr int WIDTH = 1;
+    using F = float;
+    using I = uint32_t;
+
+    static F castF(I value) {
+        F result;
+        std::memcpy(&result, &value, sizeof(result));
+        return result;
+    }
+    static I castI(F value) {
+        I result;
+        std::memcpy(&result, &value, sizeof(result));
+        return result;
+    }
+    static F set1(float value) { return value; }
+    static I set1i(uint32_t value) { return value; }
+    static F add(F a, F b) { return a + b; }
+    static F mul(F a, F b) { return a * b; }
+    static F truncate(F a) { return static_cast<float>(static_cast<int32_t>(a)); }
+    static F greater(F a, F b) { return castF(a > b ? ~0u : 0u); }
+    static F less(F a, F b) { return castF(a < b ? ~0u : 0u); }
+    static F bitAnd(F a, F b) { return castF(castI(a) & castI(b)); }
+    static F bitOr(F a, F b) { return castF(castI(a) | castI(b)); }
+    static F andNot(F a, F b) { return castF(~castI(a) & castI(b)); }
+    static I addi(I a, I b) { return a + b; }
+    static I xori(I a, I b) { return a ^ b; }
+    static I ori(I a, I b) { return a | b; }
+    template <int N> static I shiftLeft(I a) { return a << N; }
+    template <int N> static I shiftRight(I a) { return a >> N; }
+    static I signMask(I a) { return (a & 0x80000000u) ? ~0u : 0u; }
+    static I equal(I a, I b) { return a == b ? ~0u : 0u; }
+    static int moveMask(F mask) { return static_cast<int>(castI(mask) >> 31); }
+};
+
+#ifdef BATCH_HAVE_SSE2
+struct Sse2Lanes {
+    static constexpr int WIDTH = 4;
+    using F = __m128;
+    using I = __m128i;
+
+    static F castF(I value) { return _mm_castsi128_ps(value); }
+    static I castI(F value) { return _mm_castps_si128(value); }
+    static F set1(float value) { return _mm_set1_ps(value); }
+    static I set1i(uint32_t value) { return _mm_set1_epi32(static_cast<int>(value)); }
+    static F add(F a, F b) { return _mm_add_ps(a, b); }
+    static F mul(F a, F b) { return _mm_mul_ps(a, b); }
+    static F truncate(F a) { return _mm_cvtepi32_ps(_mm_cvttps_epi32(a)); }
+    static F greater(F a, F b) { return _mm_cmpgt_ps(a, b); }
+    static F less(F a, F b) { return _mm_cmplt_ps(a, b); }
+    static F bitAnd(F a, F b) { return _mm_and_ps(a, b); }
+    static F bitOr(F a, F b) { return _mm_or_ps(a, b); }
+    static F andNot(F a, F b) { return _mm_andnot_ps(a, b); }
+    static I addi(I a, I b) { return _mm_add_epi32(a, b); }
+    static I xori(I a, I b) { return _mm_xor_si128(a, b); }
+    static I ori(I a, I b) { return _mm_or_si128(a, b); }
+    template <int N> static I shiftLeft(I a) { return _mm_slli_epi32(a, N); }
+    template <int N> static I shiftRight(I a) { return _mm_srli_epi32(a, N); }
+    static I signMask(I a) { return _mm_srai_epi32(a, 31); }
+    static I equal(I a, I b) { return _mm_cmpeq_epi32(a, b); }
+    static int moveMask(F mask) { return _mm_movemask_ps(mask); }
+};
+#endif
+
+#ifdef BATCH_HAVE_AVX2
+struct Avx2Lanes {
+    static constexpr int WIDTH = 8;
+    using F = __m256;
+    using I = __m256i;
+
+    static F castF(I value) { return _mm256_castsi256_ps(value); }
+    static I castI(F value) { return _mm256_castps_si256(value); }
+    static F set1(float value) { return _mm256_set1_ps(value); }
+    static I set1i(uint32_t value) { return _mm256_set1_epi32(static_cast<int>(value)); }
+    static F add(F a, F b) { return _mm256_add_ps(a, b); }
+    static F mul(F a, F b) { return _mm256_mul_ps(a, b); }
+    static F truncate(F a) { return _mm256_round_ps(a, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC); }
+    static F greater(F a, F b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+    static F less(F a, F b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+    static F bitAnd(F a, F b) { return _mm256_and_ps(a, b); }
+    static F bitOr(F a, F b) { return _mm256_or_ps(a, b); }
+    static F andNot(F a, F b) { return _mm256_andnot_ps(a, b); }
+    static I addi(I a, I b) { return _mm256_add_epi32(a, b); }
+    static I xori(I a, I b) { return _mm256_xor_si256(a, b); }
+    static I ori(I a, I b) { return _mm256_or_si256(a, b); }
+    template <int N> static I shiftLeft(I a) { return _mm256_slli_epi32(a, N); }
+    template <int N> static I shiftRight(I a) { return _mm256_srli_epi32(a, N); }
+    static I signMask(I a) { return _mm256_srai_epi32(a, 31); }
+    static I equal(I a, I b) { return _mm256_cmpeq_epi32(a, b); }
+    static int moveMask(F mask) { return _mm256_movemask_ps(mask); }
+};
+#endif
+
+// xoshiro128+ in every lane; only the high bits of its output are used
+template <typename Lanes>
+struct LaneRng {
+    typename Lanes::I s0, s1, s2, s3;
+
+    explicit LaneRng(uint64_t seed) {
+        alignas(32) uint32_t words[4][Lanes::WIDTH];
+        uint64_t state = seed;
+        for (auto& word : words) {
+            for (int lane = 0; lane < Lanes::WIDTH; ++lane) {
+                word[lane] = static_cast<uint32_t>(splitMix64(state) >> 32);
+            }
+        }
+        std::memcpy(&s0, words[0], sizeof(s0));
+        std::memcpy(&s1, words[1], sizeof(s1));
+        std::memcpy(&s2, words[2], sizeof(s2));
+        std::memcpy(&s3, words[3], sizeof(s3));
+    }
+
+    typename Lanes::I next() {
+        auto result = Lanes::addi(s0, s3);
+        auto t = Lanes::template shiftLeft<9>(s1);
+        s2 = Lanes::xori(s2, s0);
+        s3 = Lanes::xori(s3, s1);
+        s1 = Lanes::xori(s1, s2);
+        s0 = Lanes::xori(s0, s3);
+        s2 = Lanes::xori(s2, t);
+        s3 = Lanes::ori(Lanes::template shiftLeft<11>(s3), Lanes::template shiftRight<21>(s3));
+        return result;
+    }
+};
+
+inline int laneCount(int mask) {
+    int count = 0;
+    for (unsigned bits = static_cast<unsigned>(mask); bits != 0; bits &= bits - 1) {
+        ++count;
+    }
+    return count;
+}
+
+// Plays Lanes::WIDTH games of playerCount players with the rules of
+// simulateGame and adds the outcomes to result
+template <typename Lanes>
+inline void playGameGroup(LaneRng<Lanes>& rng, int playerCount, SimulationResult& result) {
+    using F = typename Lanes::F;
+    using I = typename Lanes::I;
+
+    const F zero = Lanes::set1(0.0f);
+    const F one = Lanes::set1(1.0f);
+    const F half = Lanes::set1(0.5f);
+    const F faceCards = Lanes::set1(7.0f);  // indices 7-9 of DECK are figures
+    const F deckSize = Lanes::set1(static_cast<float>(DECK.size()));
+    const F limit = Lanes::set1(WINNING_SCORE);
+    const I exponentOne = Lanes::set1i(0x3F800000u);
+    const F allLanes = Lanes::castF(Lanes::set1i(~0u));
+
+    F scores[MAX_PLAYERS];
+    F active[MAX_PLAYERS];
+    F busted[MAX_PLAYERS];
+    for (int p = 0; p < playerCount; ++p) {
+        scores[p] = zero;
+        active[p] = allLanes;
+        busted[p] = zero;
+    }
+
+    bool anyActive = true;
+    while (anyActive) {
+        F stillActive = zero;
+        for (int p = 0; p < playerCount; ++p) {
+            // Uniform [0, 1) from the top 23 random bits, scaled to a deck
+            // index; DECK[index] is index + 1 for numbers and 0.5 for figures
+            I bits = rng.next();
+            F unit = Lanes::add(Lanes::castF(Lanes::ori(Lanes::template shiftRight<9>(bits),
+                                                         exponentOne)),
+                                Lanes::set1(-1.0f));
+            F index = Lanes::truncate(Lanes::mul(unit, deckSize));
+            F isNumber = Lanes::less(index, faceCards);
+            F card = Lanes::bitOr(Lanes::bitAnd(isNumber, Lanes::add(index, one)),
+                                  Lanes::andNot(isNumber, half));
+
+            scores[p] = Lanes::add(scores[p], Lanes::bitAnd(active[p], card));
+            F bust = Lanes::bitAnd(active[p], Lanes::greater(scores[p], limit));
+            // Stand on a coin flip, or always on exactly WINNING_SCORE (not
+            // below the limit and not busted)
+            F coin = Lanes::castF(Lanes::signMask(rng.next()));
+            F atLimit = Lanes::andNot(Lanes::less(scores[p], limit), allLanes);
+            F stand = Lanes::andNot(bust, Lanes::bitAnd(active[p], Lanes::bitOr(coin, atLimit)));
+            busted[p] = Lanes::bitOr(busted[p], bust);
+            active[p] = Lanes::andNot(Lanes::bitOr(bust, stand), active[p]);
+            stillActive = Lanes::bitOr(stillActive, active[p]);
+        }
+        anyActive = Lanes::moveMask(stillActive) != 0;
+    }
+
+    // Highest standing score wins; strict > keeps the lowest seat on ties
+    F best = Lanes::set1(-1.0f);
+    I winner = Lanes::set1i(~0u);
+    for (int p = 0; p < playerCount; ++p) {
+        F better = Lanes::andNot(busted[p], Lanes::greater(scores[p], best));
+        best = Lanes::bitOr(Lanes::bitAnd(better, scores[p]), Lanes::andNot(better, best));
+        I seat = Lanes::set1i(static_cast<uint32_t>(p));
+        winner = Lanes::castI(Lanes::bitOr(Lanes::bitAnd(better, Lanes::castF(seat)),
+                                           Lanes::andNot(better, Lanes::castF(winner))));
+
+        int bustCount = laneCount(Lanes::moveMask(busted[p]));
+        result.seats[p].busts += bustCount;
+        result.seats[p].stands += Lanes::WIDTH - bustCount;
+    }
+    for (int p = 0; p < playerCount; ++p) {
+        I seat = Lanes::set1i(static_cast<uint32_t>(p));
+        result.seats[p].wins += laneCount(Lanes::moveMask(Lanes::castF(Lanes::equal(winner, seat))));
+    }
+    result.noWinner +=
+        laneCount(Lanes::moveMask(Lanes::castF(Lanes::equal(winner, Lanes::set1i(~0u)))));
+    result.games += Lanes::WIDTH;
+}
+
+// Same chunking and reduction as runSimulation, with every chunk played by
+// the batched kernel. Chunk k seeds its lanes from (seed, k), so totals are
+// reproducible for a given kernel; games is rounded up to whole lane groups.
+template <typename Lanes>
+inline SimulationResult runBatchSimulation(uint64_t games, int playerCount, int threads,
+                                           uint64_t seed) {
+    uint64_t chunkCount = (games + SIMULATION_CHUNK_GAMES - 1) / SIMULATION_CHUNK_GAMES;
+    std::atomic<uint64_t> nextChunk{0};
+    std::vector<SimulationResult> partials(std::max(1, threads));
+
+    auto worker = [&](SimulationResult& partial) {
+        SimulationResult local;
+        for (uint64_t chunk = nextChunk++; chunk < chunkCount; chunk = nextChunk++) {
+            LaneRng<Lanes> rng(seed ^ (chunk * 0xD1B54A32D192ED03ull));
+            uint64_t first = chunk * SIMULATION_CHUNK_GAMES;
+            uint64_t count = std::min(SIMULATION_CHUNK_GAMES, games - first);
+            for (uint64_t g = 0; g < count; g += Lanes::WIDTH) {
+                playGameGroup(rng, playerCount, local);
+            }
+        }
+        partial = local;
+    };
+
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < partials.size(); ++i) {
+        workers.emplace_back(worker, std::ref(partials[i]));
+    }
+    worker(partials[0]);
+    for (auto& thread : workers) {
+        thread.join();
+    }
+
+    SimulationResult total;
+    for (const auto& partial : partials) {
+        total.merge(partial);
+    }
+    return total;
+}
+
+// Kernels available in this build, fastest first; "loop" is simulateGame
+inline std::vector<std::string> availableKernels() {
+    std::vector<std::string> kernels;
+#ifdef BATCH_HAVE_AVX2
+    kernels.push_back("avx2");
+#endif
+#ifdef BATCH_HAVE_SSE2
+    kernels.push_back("sse2");
+#endif
+    kernels.push_back("scalar");
+    kernels.push_back("loop");
+    return kernels;
+}
+
+// Runs the named kernel ("auto" picks the widest); false if not compiled in
+inline bool runKernelSimulation(const std::string& kernel, uint64_t games, int playerCount,
+                                int threads, uint64_t seed, SimulationResult& result) {
+    std::string name = kernel == "auto" ? availableKernels().front() : kernel;
+#ifdef BATCH_HAVE_AVX2
+    if (name == "avx2") {
+        result = runBatchSimulation<Avx2Lanes>(games, playerCount, threads, seed);
+        return true;
+    }
+#endif
+#ifdef BATCH_HAVE_SSE2
+    if (name == "sse2") {
+        result = runBatchSimulation<Sse2Lanes>(games, playerCount, threads, seed);
+        return true;
+    }
+#endif
+    if (name == "scalar") {
+        result = runBatchSimulation<ScalarLanes>(games, playerCount, threads, seed);
+        return true;
+    }
+    if (name == "loop") {
+        result = runSimulation(games, playerCount, threads, seed);
+        return true;
+    }
+    return false;
+}
@@ -1,21 +1,39 @@
 #include <iostream>
+#include <algorithm>
 #include <vector>
-#include <random>
 #include <iomanip>
+#include <string>
+#include <chrono>
+#include <thread>
+#include <memory>
+#include "game_rules.h"
+#include "simulation.h"
+#include "batch_kernel.h"
+#include "turn_signal.h"
+#include "strategy.h"
+#include "event_log.h"
+#include "../common/rng.h"
+#include "../common/latency_recorder.h"
+#include "../common/affinity.h"
 
 // Platform detection
 #ifdef _WIN32
     #define PLATFORM_WINDOWS
-    #include <thread>
-    #include <mutex>
-    #include <condition_variable>
-    #include <chrono>
 #else
     #define PLATFORM_UNIX
     #include <unistd.h>
     #include <sys/wait.h>
     #include <cstdlib>
-    #include <ctime>
+    #include <cerrno>
+    #include <csignal>
+    #include <fcntl.h>
+    #ifdef __linux__
+        #include <sys/epoll.h>
+    #else
+        #include <poll.h>
+    #endif
+    #include "shm_channel.h"
+    #include "../common/latency_histogram.h"
 #endif
 
 using std::cerr;
@@ -24,254 +42,640 @@ using std::cout;
 using std::fixed;
 using std::setprecision;
 using std::setw;
+using std::string;
 using std::vector;
 
-constexpr int MIN_PLAYERS = 2;
-constexpr int MAX_PLAYERS = 10;
-constexpr float WINNING_SCORE = 7.5f;
-
-struct Player {
-    int id;
-    float score;
-    bool standing;
-    bool busted;
+// Command line configuration
+struct Options {
+    int players = 0;              // 0 = ask interactively
+#ifdef PLATFORM_WINDOWS
+    string backend = "threads";   // threads only
+#else
+    string backend = "processes"; // processes | threads
+#endif
+    string transport = "pipe";    // pipe | shm (Unix only)
+    long benchRoundTrips = 0;     // > 0 runs the round-trip benchmark instead
+    int deadlineMs = 5000;        // per-player decision deadline (Unix only)
+    int thinkMs = 0;              // players think up to this long per card (Unix only)
+    long long simulateGames = 0;  // > 0 runs the headless Monte Carlo engine instead
+    int threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    uint64_t seed = 1;
+    bool seeded = false;          // --seed also makes the played games repeatable
+    string kernel = "auto";       // loop | scalar | sse2 | avx2 | auto
+    long long benchKernelGames = 0;  // > 0 compares the simulation kernels
+    long benchTurnGames = 0;      // > 0 compares turn throughput of the backends
+    string latencyJson;           // latency report written here at exit
+    ThreadPlacement placement;    // dealer on worker 0, player i on worker i + 1
+    Strategy strategy = Strategy::Optimal;  // how players choose to hit or stand
+    string eventLogPath;          // binary event log replacing the per-card output
+    EventLogWriter* eventLog = nullptr;  // opened from eventLogPath by main
 };
 
-#ifdef PLATFORM_WINDOWS
+constexpr int DEFAULT_SIMULATION_PLAYERS = 4;
+
+// Runs the headless simulation and prints per-seat rates and throughput
+int runSimulationMode(const Options& options) {
+    int playerCount = options.players != 0 ? options.players : DEFAULT_SIMULATION_PLAYERS;
+    string kernel = options.kernel == "auto" ? availableKernels().front() : options.kernel;
+    SimulationResult result;
+    auto start = std::chrono::steady_clock::now();
+    if (!runKernelSimulation(kernel, static_cast<uint64_t>(options.simulateGames), playerCount,
+                             options.threads, options.seed, result)) {
+        cerr << "Kernel " << kernel << " is not available in this build\n";
+        return 1;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    auto percent = [&](uint64_t count) {
+        return 100.0 * static_cast<double>(count) / static_cast<double>(result.games);
+    };
+
+    cout << "Simulated " << result.games << " games of " << playerCount << " players on "
+         << options.threads << " threads (seed " << options.seed << ", kernel " << kernel
+         << ")\n"
+         << "Elapsed: " << fixed << setprecision(3) << seconds << " s, "
+         << setprecision(0) << result.games / seconds << " games/s\n\n"
+         << "Seat | Win %  | Bust % | Stand %\n"
+         << "-----------------------------------\n"
+         << setprecision(2);
+    for (int i = 0; i < playerCount; ++i) {
+        const SeatStats& seat = result.seats[i];
+        cout << setw(4) << i << " | " << setw(6) << percent(seat.wins) << " | " << setw(6)
+             << percent(seat.busts) << " | " << setw(7) << percent(seat.stands) << "\n";
+    }
+    cout << "\nNo winner: " << percent(result.noWinner) << " %\n";
+    return 0;
+}
 
-// Windows implementation using threads
-#include <thread>
-#include <mutex>
-#include <condition_variable>
+// Plays the same number of games on one thread with every kernel compiled in
+int runKernelBenchmark(const Options& options) {
+    int playerCount = options.players != 0 ? options.players : DEFAULT_SIMULATION_PLAYERS;
+    uint64_t games = static_cast<uint64_t>(options.benchKernelGames);
+    double loopRate = 0;
+
+    cout << "Games: " << games << " of " << playerCount << " players, 1 thread per kernel\n"
+         << "Kernel | games/s/core | vs loop | seat 0 win %\n";
+    vector<string> kernels = availableKernels();
+    std::reverse(kernels.begin(), kernels.end());  // loop first, as the baseline
+    for (const string& kernel : kernels) {
+        SimulationResult result;
+        auto start = std::chrono::steady_clock::now();
+        runKernelSimulation(kernel, games, playerCount, 1, options.seed, result);
+        double seconds =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        double rate = result.games / seconds;
+        if (kernel == "loop") {
+            loopRate = rate;
+        }
+        cout << setw(6) << kernel << " | " << setw(12) << fixed << setprecision(0) << rate
+             << " | " << setw(6) << setprecision(2) << rate / loopRate << "x | " << setw(12)
+             << 100.0 * result.seats[0].wins / result.games << "\n";
+    }
+    return 0;
+}
+
+// Prints the final table; timedOut is empty when no player can time out
+void printResults(const vector<Player>& players, const vector<bool>& timedOut) {
+    cout << "\n=== Results ===\n";
+    cout << "Player | Score  | Status\n";
+    cout << "-----------------------------\n";
+
+    for (const auto& player : players) {
+        cout << setw(6) << player.id << " | " 
+             << setw(6) << fixed << setprecision(1) << player.score << " | ";
 
-using std::condition_variable;
-using std::lock_guard;
-using std::mutex;
-using std::thread;
-using std::unique_lock;
+        if (player.busted) {
+            cout << "Busted\n";
+        } else {
+            bool late = !timedOut.empty() && timedOut[player.id];
+            cout << (late ? "Standing (timed out)\n" : "Standing\n");
+        }
+    }
+
+    int winnerId = findWinner(players.data(), static_cast<int>(players.size()));
+    if (winnerId != -1) {
+        cout << "\n🎉 Player " << winnerId << " wins with " << players[winnerId].score
+             << " points!\n";
+    } else {
+        cout << "\nNo winner.\n";
+    }
+}
+
+// What the player did with its last card
+void logDecision(EventLogWriter& log, const Player& player) {
+    GameEventType type = player.busted ? EVENT_BUST : player.standing ? EVENT_STAND : EVENT_HIT;
+    log.append(type, player.id, toHalfPoints(player.score));
+}
+
+void logGameEnd(EventLogWriter& log, const Player* players, int playerCount) {
+    int winner = findWinner(players, playerCount);
+    if (winner == -1) {
+        log.endGame(NO_WINNER, 0);
+    } else {
+        log.endGame(winner, players[winner].score);
+    }
+}
+
+// Threaded backend: the dealer and every player are threads of one process.
+// The dealer hands the turn straight to one player through that player's
+// TurnSignal and the player hands it back the same way, so no thread is
+// woken just to find out that it is not its turn.
+
+// One seat, on its own cache lines so players never share a line
+struct alignas(64) PlayerSlot {
+    Player player;
+    float card = 0;
+    uint64_t postedAtNs = 0;  // when the dealer posted the turn, 0 if not measured
+    TurnSignal turn;          // dealer -> this player
+};
+
+const int TURN_WAKE_METRIC = LatencyRecorder::instance().metric("card_game.turn_wake");
 
 struct GameState {
-    vector<Player> players;
-    vector<float> deck;
-    mutex mtx;
-    condition_variable cv;
-    int currentPlayer;
-    bool gameOver;
-    float currentCard;
-    bool hasCard;
-    
-    GameState(int playerCount) 
-        : players(playerCount), 
-          deck{1, 2, 3, 4, 5, 6, 7, 0.5, 0.5, 0.5},
-          currentPlayer(0),
-          gameOver(false),
-          currentCard(0),
-          hasCard(false) {
-        for (int i = 0; i < playerCount; ++i) {
-            players[i] = {i, 0, false, false};
+    std::unique_ptr<PlayerSlot[]> slots;
+    int playerCount;
+    alignas(64) TurnSignal dealerTurn;  // player -> dealer
+    bool gameOver = false;              // published by the final turn posts
+    bool verbose;
+    Strategy strategy;
+    EventLogWriter* log;
+    uint64_t turns = 0;
+
+    GameState(int count, bool verboseOutput, Strategy playerStrategy, EventLogWriter* eventLog)
+        : slots(new PlayerSlot[count]), playerCount(count), verbose(verboseOutput),
+          strategy(playerStrategy), log(eventLog) {
+        for (int i = 0; i < count; ++i) {
+            slots[i].player = {i, 0, false, false};
         }
     }
 };
 
-void playerThread(int id, GameState& state) {
-    std::random_device rd;
-    std::mt19937 gen(rd());
+void playerThread(int id, uint64_t stream, GameState& state) {
+    seedThreadRng(stream);
+    Xoshiro256& rng = threadRng();
+    PlayerSlot& slot = state.slots[id];
+    Player& player = slot.player;
     
     while (true) {
-        unique_lock<mutex> lock(state.mtx);
-        
-        state.cv.wait(lock, [&]() { 
-            return state.gameOver || 
-                   (state.currentPlayer == id && state.hasCard);
-        });
-        
+        slot.turn.wait();
         if (state.gameOver) break;
+        if (slot.postedAtNs != 0) {
+            LatencyRecorder::instance().recordSince(TURN_WAKE_METRIC, slot.postedAtNs);
+            slot.postedAtNs = 0;
+        }
         
-        Player& player = state.players[id];
-        
-        if (state.hasCard && state.currentPlayer == id) {
-            player.score += state.currentCard;
-            state.hasCard = false;
-            
+        player.score += slot.card;
+        if (state.verbose) {
             cout << "Player " << id << " received: " << fixed 
-                 << setprecision(1) << state.currentCard 
+                 << setprecision(1) << slot.card 
                  << " (Total: " << player.score << ")\n";
-            
-            if (player.score > WINNING_SCORE) {
-                player.busted = true;
-                cout << "Player " << id << " BUSTED!\n";
-            } else {
-                int decision = gen() % 2;
-                if (decision == 1 || player.score == WINNING_SCORE) {
-                    player.standing = true;
-                    cout << "Player " << id << " stands\n";
-                }
+        }
+        
+        int decision = decide(state.strategy, state.playerCount, id, player.score, rng);
+        if (decision == DECISION_BUST) {
+            player.busted = true;
+            if (state.verbose) cout << "Player " << id << " BUSTED!\n";
+        } else {
+            if (decision == DECISION_STAND) {
+                player.standing = true;
+                if (state.verbose) cout << "Player " << id << " stands\n";
             }
-            
-            state.cv.notify_all();
         }
+        
+        state.dealerTurn.post();
     }
 }
 
-void dealerThread(GameState& state) {
-    std::random_device rd;
-    std::mt19937 gen(rd());
+void dealerThread(uint64_t stream, GameState& state) {
+    seedThreadRng(stream);
+    Xoshiro256& rng = threadRng();
     
-    cout << "\n=== Game Starting (Windows - Threads) ===\n\n";
+    if (state.verbose) cout << "\n=== Game Starting (Threads) ===\n\n";
+    if (state.log) state.log->beginGame(state.playerCount);
     
-    while (true) {
-        unique_lock<mutex> lock(state.mtx);
-        
-        bool allDone = true;
-        for (const auto& player : state.players) {
-            if (!player.standing && !player.busted) {
-                allDone = false;
-                break;
+    bool anyActive = true;
+    while (anyActive) {
+        anyActive = false;
+        for (int i = 0; i < state.playerCount; ++i) {
+            PlayerSlot& slot = state.slots[i];
+            if (slot.player.standing || slot.player.busted) continue;
+
+            anyActive = true;
+            slot.card = DECK[rng.below(DECK.size())];
+            if (LatencyRecorder::instance().enabled()) {
+                slot.postedAtNs = LatencyRecorder::now();
             }
+            if (state.log) state.log->append(EVENT_DEAL, i, toHalfPoints(slot.card));
+            slot.turn.post();
+            state.dealerTurn.wait();
+            ++state.turns;
+            if (state.log) logDecision(*state.log, slot.player);
         }
-        
-        if (allDone) {
-            state.gameOver = true;
-            state.cv.notify_all();
-            break;
-        }
-        
-        bool foundPlayer = false;
-        for (size_t i = 0; i < state.players.size(); ++i) {
-            int playerIdx = (state.currentPlayer + i) % state.players.size();
-            if (!state.players[playerIdx].standing && !state.players[playerIdx].busted) {
-                state.currentPlayer = playerIdx;
-                foundPlayer = true;
-                break;
-            }
-        }
-        
-        if (!foundPlayer) continue;
-        
-        Player& player = state.players[state.currentPlayer];
-        if (!state.hasCard) {
-            state.currentCard = state.deck[gen() % state.deck.size()];
-            state.hasCard = true;
-            
-            state.cv.notify_all();
-            state.cv.wait(lock, [&]() { return !state.hasCard || state.gameOver; });
+    }
+
+    if (state.log) {
+        Player players[MAX_PLAYERS];
+        for (int i = 0; i < state.playerCount; ++i) {
+            players[i] = state.slots[i].player;
         }
-        
-        state.currentPlayer = (state.currentPlayer + 1) % state.players.size();
-        lock.unlock();
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        logGameEnd(*state.log, players, state.playerCount);
+    }
+
+    state.gameOver = true;
+    for (int i = 0; i < state.playerCount; ++i) {
+        state.slots[i].turn.post();
     }
 }
 
-int runGame(int playerCount) {
-    GameState state(playerCount);
-    vector<thread> playerThreads;
+// Plays one game on threads and returns the number of turns (cards dealt)
+uint64_t playThreadedGame(int playerCount, bool verbose, const Options& options) {
+    const ThreadPlacement& placement = options.placement;
+    // With an event log the per-card lines go to the log instead
+    GameState state(playerCount, verbose && options.eventLog == nullptr, options.strategy,
+                    options.eventLog);
+    vector<std::thread> playerThreads;
 
+    // Each thread's stream is drawn from ours, so a seeded run replays the game
+    Xoshiro256& rng = threadRng();
     for (int i = 0; i < playerCount; ++i) {
-        playerThreads.emplace_back(playerThread, i, std::ref(state));
+        playerThreads.emplace_back(playerThread, i, rng.next(), std::ref(state));
+        placement.pinThread(playerThreads.back(), i + 1);
     }
 
-    thread dealer(dealerThread, std::ref(state));
+    std::thread dealer(dealerThread, rng.next(), std::ref(state));
+    placement.pinThread(dealer, 0);
     dealer.join();
     
     for (auto& t : playerThreads) {
         t.join();
     }
 
-    // Display results
-    float bestScore = -1;
-    int winnerId = -1;
+    if (verbose) {
+        vector<Player> players;
+        for (int i = 0; i < playerCount; ++i) {
+            players.push_back(state.slots[i].player);
+        }
+        printResults(players, {});
+    }
+    return state.turns;
+}
 
-    cout << "\n=== Results ===\n";
-    cout << "Player | Score  | Status\n";
-    cout << "-----------------------------\n";
+#ifdef PLATFORM_WINDOWS
 
-    for (const auto& player : state.players) {
-        cout << setw(6) << player.id << " | " 
-             << setw(6) << fixed << setprecision(1) << player.score << " | ";
+int runRoundTripBenchmark(const Options&) {
+    cerr << "The round-trip benchmark is only available on Unix (fork)\n";
+    return 1;
+}
 
-        if (player.busted) {
-            cout << "Busted\n";
-        } else {
-            cout << "Standing\n";
-            if (player.score > bestScore) {
-                bestScore = player.score;
-                winnerId = player.id;
-            }
-        }
+int runGame(int playerCount, const Options& options) {
+    playThreadedGame(playerCount, true, options);
+    return 0;
+}
+
+#else
+
+// Unix/Linux implementation using forked players, connected to the dealer
+// through pipes or through shared-memory rings (--transport)
+constexpr int READ_END = 0;
+constexpr int WRITE_END = 1;
+constexpr long BENCH_WARMUP_ROUND_TRIPS = 1000;
+constexpr float NO_MORE_CARDS = -1;  // tells a player to leave the table
+constexpr int NO_DECISION = -1;      // the player missed the deadline or left
+
+// Dealer <-> player connection of one player
+struct PlayerLink {
+    int cardPipe[2] = {-1, -1};      // dealer -> player
+    int decisionPipe[2] = {-1, -1};  // player -> dealer
+    ShmLink* shm = nullptr;          // set when using the shared-memory backend
+};
+
+// Creates the pipes, or points the link at its slot of the shared channel
+bool openLink(PlayerLink& link, ShmChannel* channel, int index) {
+    if (channel != nullptr) {
+        link.shm = &channel->link(index);
+        return true;
     }
+    return pipe(link.cardPipe) != -1 && pipe(link.decisionPipe) != -1;
+}
 
-    if (winnerId != -1) {
-        cout << "\n🎉 Player " << winnerId << " wins with " << bestScore << " points!\n";
+// Keeps only the ends the given side uses (no-op for shared memory)
+void closeUnusedEnds(PlayerLink& link, bool dealerSide) {
+    if (link.shm != nullptr) {
+        return;
+    }
+    close(dealerSide ? link.cardPipe[READ_END] : link.cardPipe[WRITE_END]);
+    close(dealerSide ? link.decisionPipe[WRITE_END] : link.decisionPipe[READ_END]);
+}
+
+void closeLink(PlayerLink& link, bool dealerSide) {
+    if (link.shm != nullptr) {
+        return;
+    }
+    close(dealerSide ? link.cardPipe[WRITE_END] : link.cardPipe[READ_END]);
+    close(dealerSide ? link.decisionPipe[READ_END] : link.decisionPipe[WRITE_END]);
+}
+
+void sendCard(PlayerLink& link, float card) {
+    if (link.shm != nullptr) {
+        link.shm->cards.push(card);
     } else {
-        cout << "\nNo winner.\n";
+        write(link.cardPipe[WRITE_END], &card, sizeof(float));
     }
+}
 
-    return 0;
+float receiveCard(PlayerLink& link) {
+    if (link.shm != nullptr) {
+        return link.shm->cards.pop();
+    }
+    float card = 0;
+    read(link.cardPipe[READ_END], &card, sizeof(float));
+    return card;
 }
 
+void sendDecision(PlayerLink& link, int decision) {
+    if (link.shm != nullptr) {
+        link.shm->decisions.push(decision);
+    } else {
+        write(link.decisionPipe[WRITE_END], &decision, sizeof(int));
+    }
+}
+
+int receiveDecision(PlayerLink& link) {
+    if (link.shm != nullptr) {
+        return link.shm->decisions.pop();
+    }
+    int decision = 0;
+    read(link.decisionPipe[READ_END], &decision, sizeof(int));
+    return decision;
+}
+
+// Waits for decisions on the dealer's ends of the decision pipes: epoll on
+// Linux, poll() on other Unix systems. Pipes are switched to non-blocking so
+// a spurious wakeup can never stall the dealer in read().
+class DecisionPoller {
+private:
+#ifdef __linux__
+    int epollFd_;
 #else
+    vector<pollfd> fds_;
+    vector<int> playerOf_;
+#endif
 
-// Unix/Linux implementation using pipes
-constexpr int READ_END = 0;
-constexpr int WRITE_END = 1;
+public:
+    DecisionPoller() {
+#ifdef __linux__
+        epollFd_ = epoll_create1(0);
+#endif
+    }
+
+    DecisionPoller(const DecisionPoller&) = delete;
+    DecisionPoller& operator=(const DecisionPoller&) = delete;
+
+    ~DecisionPoller() {
+#ifdef __linux__
+        close(epollFd_);
+#endif
+    }
 
-void playerProcess(int id, int readPipe, int writePipe) {
-    srand(time(nullptr) + id);
+    void add(int fd, int player) {
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+#ifdef __linux__
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.u32 = static_cast<uint32_t>(player);
+        epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &event);
+#else
+        fds_.push_back({fd, POLLIN, 0});
+        playerOf_.push_back(player);
+#endif
+    }
+
+    // Players that left the table must be removed, or their closed pipes
+    // would report hang-up on every wait
+    void remove(int fd) {
+#ifdef __linux__
+        epoll_ctl(epollFd_, EPOLL_CTL_DEL, fd, nullptr);
+#else
+        for (size_t i = 0; i < fds_.size(); ++i) {
+            if (fds_[i].fd == fd) {
+                fds_.erase(fds_.begin() + i);
+                playerOf_.erase(playerOf_.begin() + i);
+                break;
+            }
+        }
+#endif
+    }
+
+    // Fills ready with the players whose pipe can be read; empty on timeout
+    void wait(int timeoutMs, vector<int>& ready) {
+        ready.clear();
+#ifdef __linux__
+        epoll_event events[MAX_PLAYERS];
+        int count = epoll_wait(epollFd_, events, MAX_PLAYERS, timeoutMs);
+        for (int i = 0; i < count; ++i) {
+            ready.push_back(static_cast<int>(events[i].data.u32));
+        }
+#else
+        int count = poll(fds_.data(), fds_.size(), timeoutMs);
+        for (size_t i = 0; count > 0 && i < fds_.size(); ++i) {
+            if (fds_[i].revents != 0) {
+                ready.push_back(playerOf_[i]);
+            }
+        }
+#endif
+    }
+};
+
+const int PIPE_ROUND_TRIP_METRIC = LatencyRecorder::instance().metric("card_game.card_to_decision.pipe");
+const int SHM_ROUND_TRIP_METRIC = LatencyRecorder::instance().metric("card_game.card_to_decision.shm");
+
+// Collects one decision from every pending player, in whatever order they
+// arrive; players still silent at the deadline get NO_DECISION. sentAtNs holds
+// when each card went out (0 when latencies are not recorded).
+void collectDecisions(vector<PlayerLink>& links, const vector<int>& pending,
+                      std::chrono::steady_clock::time_point deadline,
+                      DecisionPoller* poller, const vector<uint64_t>& sentAtNs,
+                      vector<int>& decisions) {
+    for (int i : pending) {
+        decisions[i] = NO_DECISION;
+    }
+    auto recordRoundTrip = [&](int metric, int player) {
+        if (sentAtNs[player] != 0) {
+            LatencyRecorder::instance().recordSince(metric, sentAtNs[player]);
+        }
+    };
+
+    if (poller == nullptr) {
+        // Shared memory: the players think in parallel, so waiting on them in
+        // turn still ends when the slowest one has answered
+        for (int i : pending) {
+            int32_t decision;
+            if (links[i].shm->decisions.popUntil(decision, deadline)) {
+                recordRoundTrip(SHM_ROUND_TRIP_METRIC, i);
+                decisions[i] = decision;
+            }
+        }
+        return;
+    }
+
+    vector<bool> waiting(links.size(), false);
+    for (int i : pending) {
+        waiting[i] = true;
+    }
+    size_t remaining = pending.size();
+    vector<int> ready;
+
+    while (remaining > 0) {
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now());
+        if (left.count() < 0) {
+            break;
+        }
+        poller->wait(static_cast<int>(left.count()) + 1, ready);
+
+        for (int i : ready) {
+            int decision;
+            ssize_t bytes = read(links[i].decisionPipe[READ_END], &decision, sizeof(int));
+            if (bytes == -1 && errno == EAGAIN) {
+                continue;
+            }
+            if (bytes != sizeof(int)) {
+                // The player exited or broke the protocol: stop waiting for it
+                poller->remove(links[i].decisionPipe[READ_END]);
+                decision = NO_DECISION;
+            }
+            if (waiting[i]) {
+                if (decision != NO_DECISION) {
+                    recordRoundTrip(PIPE_ROUND_TRIP_METRIC, i);
+                }
+                waiting[i] = false;
+                decisions[i] = decision;
+                --remaining;
+            }
+            // Otherwise a late answer to an earlier round: discard it
+        }
+    }
+}
+
+void playerProcess(PlayerLink& link, int playerCount, int seat, const Options& options,
+                   uint64_t stream) {
+    seedThreadRng(stream);  // the fork copied the dealer's generator
+    Xoshiro256& rng = threadRng();
     float score = 0;
     bool standing = false;
 
     while (!standing && score <= WINNING_SCORE) {
-        float card;
-        read(readPipe, &card, sizeof(float));
+        float card = receiveCard(link);
+        if (card == NO_MORE_CARDS) break;
         score += card;
 
-        int decision;
-        if (score > WINNING_SCORE) {
-            decision = 2;
-        } else {
-            decision = rand() % 2;
+        if (options.thinkMs > 0) {
+            usleep(static_cast<useconds_t>(rng.uniformInt(0, options.thinkMs)) * 1000);
         }
 
-        if (decision == 1) standing = true;
-        write(writePipe, &decision, sizeof(int));
-        if (decision == 2) break;
+        int decision = decide(options.strategy, playerCount, seat, score, rng);
+
+        if (decision == DECISION_STAND) standing = true;
+        sendDecision(link, decision);
+        if (decision == DECISION_BUST) break;
     }
 
-    close(readPipe);
-    close(writePipe);
+    closeLink(link, false);
 }
 
-void startGame(int playerCount, const vector<int>& readPipes, const vector<int>& writePipes) {
+// Deals the game and returns the number of turns (cards dealt)
+uint64_t startGame(int playerCount, vector<PlayerLink>& links, const Options& options,
+                   bool verbose) {
+    bool sharedMemory = options.transport == "shm";
     vector<Player> players(playerCount);
-    vector<float> deck = {1, 2, 3, 4, 5, 6, 7, 0.5, 0.5, 0.5};
-    srand(time(nullptr));
+    vector<float> deck(DECK.begin(), DECK.end());
+    Xoshiro256& rng = threadRng();
 
-    cout << "\n=== Game Starting (Unix - Pipes) ===\n\n";
+    if (verbose) {
+        cout << "\n=== Game Starting (Unix - " << (sharedMemory ? "Shared Memory" : "Pipes")
+             << ") ===\n\n";
+    }
 
+    std::unique_ptr<DecisionPoller> poller;
+    if (!sharedMemory) {
+        poller = std::make_unique<DecisionPoller>();
+    }
+    EventLogWriter* log = options.eventLog;
+    if (log) {
+        log->beginGame(playerCount);
+    }
     for (int i = 0; i < playerCount; ++i) {
         players[i] = {i, 0, false, false};
+        if (poller) {
+            poller->add(links[i].decisionPipe[READ_END], i);
+        }
     }
 
+    vector<bool> timedOut(playerCount, false);
+    vector<float> dealt(playerCount, 0);
+    vector<int> decisions(playerCount, NO_DECISION);
+    vector<uint64_t> sentAtNs(playerCount, 0);
+    bool timed = LatencyRecorder::instance().enabled();
+    vector<int> pending;
+    int rounds = 0;
+    uint64_t turns = 0;
+    double totalRoundMs = 0;
+    double slowestRoundMs = 0;
+
     bool gameOver = false;
     while (!gameOver) {
+        // Deal the whole round first, then take decisions as they come in
+        auto roundStart = std::chrono::steady_clock::now();
+        pending.clear();
         for (int i = 0; i < playerCount; ++i) {
             if (!players[i].standing && !players[i].busted) {
-                float card = deck[rand() % deck.size()];
-                write(writePipes[i], &card, sizeof(float));
-
-                int decision;
-                read(readPipes[i], &decision, sizeof(int));
-                players[i].score += card;
-
-                if (decision == 1) {
-                    players[i].standing = true;
-                } else if (decision == 2) {
-                    players[i].busted = true;
+                dealt[i] = deck[rng.below(deck.size())];
+                sentAtNs[i] = timed ? LatencyRecorder::now() : 0;
+                sendCard(links[i], dealt[i]);
+                if (log) {
+                    log->append(EVENT_DEAL, i, toHalfPoints(dealt[i]));
                 }
+                pending.push_back(i);
+                ++turns;
+            }
+        }
+
+        collectDecisions(links, pending, roundStart + std::chrono::milliseconds(options.deadlineMs),
+                         poller.get(), sentAtNs, decisions);
+
+        for (int i : pending) {
+            players[i].score += dealt[i];
+
+            // The dealer applies the limit itself: a timed-out player, or one
+            // that reports anything else, is out once the card takes it over
+            players[i].busted = players[i].score > WINNING_SCORE;
+            if (players[i].busted) {
+                // Over the limit whatever the player answered
+            } else if (decisions[i] == NO_DECISION) {
+                // Too slow: the player stands on what it has
+                timedOut[i] = true;
+                players[i].standing = true;
+            } else if (decisions[i] == DECISION_STAND) {
+                players[i].standing = true;
+            } else if (decisions[i] == DECISION_BUST) {
+                players[i].busted = true;
+            }
+            if (poller && (players[i].standing || players[i].busted)) {
+                poller->remove(links[i].decisionPipe[READ_END]);
+            }
+            if (log && timedOut[i]) {
+                log->append(EVENT_TIMEOUT, i, toHalfPoints(players[i].score));
+            } else if (log) {
+                logDecision(*log, players[i]);
             }
         }
 
+        double roundMs = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - roundStart).count();
+        ++rounds;
+        totalRoundMs += roundMs;
+        slowestRoundMs = std::max(slowestRoundMs, roundMs);
+
         gameOver = true;
         for (const auto& player : players) {
             if (!player.standing && !player.busted) {
@@ -281,76 +685,119 @@ void startGame(int playerCount, const vector<int>& readPipes, const vector<int>&
         }
     }
 
-    // Display results
-    float bestScore = -1;
-    int winnerId = -1;
+    if (log) {
+        logGameEnd(*log, players.data(), playerCount);
+    }
+    if (verbose) {
+        printResults(players, timedOut);
+        cout << "\nRounds: " << rounds << ", mean round " << setprecision(1)
+             << totalRoundMs / rounds << " ms, slowest " << slowestRoundMs << " ms\n";
+    }
 
-    cout << "\n=== Results ===\n";
-    cout << "Player | Score  | Status\n";
-    cout << "-----------------------------\n";
+    // Players that timed out are still waiting for a card
+    for (int i = 0; i < playerCount; ++i) {
+        if (timedOut[i]) {
+            sendCard(links[i], NO_MORE_CARDS);
+        }
+        closeLink(links[i], true);
+    }
+    return turns;
+}
 
-    for (const auto& player : players) {
-        cout << setw(6) << player.id << " | " 
-             << setw(6) << fixed << setprecision(1) << player.score << " | ";
+// Measures dealer -> player -> dealer round trips against an echoing child
+LatencyHistogram measureRoundTrips(bool sharedMemory, long roundTrips) {
+    LatencyHistogram latency;
+    std::unique_ptr<ShmChannel> channel;
+    if (sharedMemory) {
+        channel = std::make_unique<ShmChannel>(1);
+    }
 
-        if (player.busted) {
-            cout << "Busted\n";
-        } else {
-            cout << "Standing\n";
-            if (player.score > bestScore) {
-                bestScore = player.score;
-                winnerId = player.id;
-            }
-        }
+    PlayerLink link;
+    if (!openLink(link, channel.get(), 0)) {
+        cerr << "Error creating pipes\n";
+        return latency;
     }
 
-    if (winnerId != -1) {
-        cout << "\n🎉 Player " << winnerId << " wins with " << bestScore << " points!\n";
-    } else {
-        cout << "\nNo winner.\n";
+    pid_t pid = fork();
+    if (pid == -1) {
+        cerr << "Error creating child process\n";
+        return latency;
+    } else if (pid == 0) {
+        closeUnusedEnds(link, false);
+        while (receiveCard(link) != NO_MORE_CARDS) {
+            sendDecision(link, DECISION_HIT);
+        }
+        _exit(0);
+    }
+    closeUnusedEnds(link, true);
+
+    for (long i = 0; i < BENCH_WARMUP_ROUND_TRIPS + roundTrips; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        sendCard(link, 1);
+        receiveDecision(link);
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        if (i >= BENCH_WARMUP_ROUND_TRIPS) {
+            latency.record(static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+        }
     }
 
-    for (int pipe : readPipes) close(pipe);
-    for (int pipe : writePipes) close(pipe);
+    sendCard(link, NO_MORE_CARDS);
+    waitpid(pid, nullptr, 0);
+    closeLink(link, true);
+    return latency;
+}
+
+int runRoundTripBenchmark(const Options& options) {
+    cout << "Round trips: " << options.benchRoundTrips << " per transport\n"
+         << "Transport | mean ns | p50 ns | p99 ns | p99.9 ns\n";
+    for (bool sharedMemory : {false, true}) {
+        LatencyHistogram latency = measureRoundTrips(sharedMemory, options.benchRoundTrips);
+        cout << setw(9) << (sharedMemory ? "shm" : "pipe") << " | " << setw(7) << fixed
+             << setprecision(0) << latency.mean() << " | " << setw(6) << latency.percentile(50)
+             << " | " << setw(6) << latency.percentile(99) << " | " << setw(8)
+             << latency.percentile(99.9) << "\n";
+    }
+    return 0;
 }
 
-int runGame(int playerCount) {
-    vector<int> playerToDealerPipes[2];
-    vector<int> dealerToPlayerPipes[2];
+// Plays one game with forked players; turns receives the cards dealt
+int playForkedGame(int playerCount, const Options& options, bool verbose, uint64_t& turns) {
+    std::unique_ptr<ShmChannel> channel;
+    if (options.transport == "shm") {
+        channel = std::make_unique<ShmChannel>(playerCount, options.placement.memoryNode());
+    }
+    options.placement.pinCurrentThread(0);
+    // A player may already have left when the dealer sends NO_MORE_CARDS
+    signal(SIGPIPE, SIG_IGN);
+
+    vector<PlayerLink> links(playerCount);
     vector<pid_t> playerPids;
 
     for (int i = 0; i < playerCount; ++i) {
-        int pipePlayerToDealer[2];
-        int pipeDealerToPlayer[2];
-        
-        if (pipe(pipePlayerToDealer) == -1 || pipe(pipeDealerToPlayer) == -1) {
+        if (!openLink(links[i], channel.get(), i)) {
             cerr << "Error creating pipes\n";
             return 1;
         }
 
-        playerToDealerPipes[READ_END].push_back(pipePlayerToDealer[READ_END]);
-        playerToDealerPipes[WRITE_END].push_back(pipePlayerToDealer[WRITE_END]);
-        dealerToPlayerPipes[READ_END].push_back(pipeDealerToPlayer[READ_END]);
-        dealerToPlayerPipes[WRITE_END].push_back(pipeDealerToPlayer[WRITE_END]);
-
+        uint64_t stream = threadRng().next();
         pid_t pid = fork();
 
         if (pid == -1) {
             cerr << "Error creating child process\n";
             return 1;
         } else if (pid == 0) {
-            close(pipePlayerToDealer[READ_END]);
-            close(pipeDealerToPlayer[WRITE_END]);
-            playerProcess(i, pipeDealerToPlayer[READ_END], pipePlayerToDealer[WRITE_END]);
-            return 0;
+            closeUnusedEnds(links[i], false);
+            options.placement.pinCurrentThread(i + 1);
+            playerProcess(links[i], playerCount, i, options, stream);
+            _exit(0);
         } else {
-            close(pipePlayerToDealer[WRITE_END]);
-            close(pipeDealerToPlayer[READ_END]);
+            closeUnusedEnds(links[i], true);
             playerPids.push_back(pid);
         }
     }
 
-    startGame(playerCount, playerToDealerPipes[READ_END], dealerToPlayerPipes[WRITE_END]);
+    turns = startGame(playerCount, links, options, verbose);
 
     for (pid_t pid : playerPids) {
         waitpid(pid, nullptr, 0);
@@ -359,10 +806,174 @@ int runGame(int playerCount) {
     return 0;
 }
 
+int runGame(int playerCount, const Options& options) {
+    if (options.placement.enabled()) {
+        cout << "Placement: " << options.placement.describe(playerCount + 1) << "\n";
+    }
+    if (options.backend == "threads") {
+        playThreadedGame(playerCount, true, options);
+        return 0;
+    }
+    uint64_t turns = 0;
+    return playForkedGame(playerCount, options, true, turns);
+}
+
 #endif
 
-int main() {
-    int playerCount;
+// Plays the same number of quiet games on every backend and compares turns/s
+int runTurnBenchmark(const Options& options) {
+    int playerCount = options.players != 0 ? options.players : DEFAULT_SIMULATION_PLAYERS;
+    vector<string> backends = {"threads"};
+#ifdef PLATFORM_UNIX
+    backends.insert(backends.begin(), {"fork+pipe", "fork+shm"});
+#endif
+
+    cout << "Games: " << options.benchTurnGames << " of " << playerCount << " players\n"
+         << "Placement: " << options.placement.describe(playerCount + 1) << "\n"
+         << "Strategy: " << strategyName(options.strategy) << "\n"
+         << "  Backend | turns/s  | games/s\n";
+    for (const string& backend : backends) {
+        uint64_t turns = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (long game = 0; game < options.benchTurnGames; ++game) {
+            if (backend == "threads") {
+                turns += playThreadedGame(playerCount, false, options);
+                continue;
+            }
+#ifdef PLATFORM_UNIX
+            Options forked = options;
+            forked.transport = backend == "fork+shm" ? "shm" : "pipe";
+            uint64_t gameTurns = 0;
+            if (playForkedGame(playerCount, forked, false, gameTurns) != 0) {
+                return 1;
+            }
+            turns += gameTurns;
+#endif
+        }
+        double seconds =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        cout << setw(9) << backend << " | " << setw(8) << fixed << setprecision(0)
+             << turns / seconds << " | " << setw(7) << options.benchTurnGames / seconds << "\n";
+    }
+    return 0;
+}
+
+void printUsage() {
+    cerr << "Usage: card_game [--players N] [--backend processes|threads]\n"
+         << "       [--transport pipe|shm] [--deadline-ms MS] [--think-ms MAX] [--seed S]\n"
+         << "       [--latency-json PATH|-]\n"
+         << "       [--placement none|compact|scatter|node[:N]] [--strategy optimal|coin]\n"
+         << "       [--event-log PATH]\n"
+         << "       card_game --bench-turns GAMES [--players N] [--placement POLICY]\n"
+         << "                 [--strategy optimal|coin] [--event-log PATH]\n"
+         << "       card_game --bench-rtt ROUND_TRIPS\n"
+         << "       card_game --simulate GAMES [--players N] [--threads N] [--seed S]\n"
+         << "                 [--kernel loop|scalar|sse2|avx2|auto]\n"
+         << "       card_game --bench-kernels GAMES [--players N]\n";
+}
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (arg == "--players" && hasValue) {
+            options.players = std::stoi(argv[++i]);
+        } else if (arg == "--backend" && hasValue) {
+            options.backend = argv[++i];
+        } else if (arg == "--bench-turns" && hasValue) {
+            options.benchTurnGames = std::stol(argv[++i]);
+        } else if (arg == "--transport" && hasValue) {
+            options.transport = argv[++i];
+        } else if (arg == "--deadline-ms" && hasValue) {
+            options.deadlineMs = std::stoi(argv[++i]);
+        } else if (arg == "--think-ms" && hasValue) {
+            options.thinkMs = std::stoi(argv[++i]);
+        } else if (arg == "--simulate" && hasValue) {
+            options.simulateGames = std::stoll(argv[++i]);
+        } else if (arg == "--threads" && hasValue) {
+            options.threads = std::stoi(argv[++i]);
+        } else if (arg == "--kernel" && hasValue) {
+            options.kernel = argv[++i];
+        } else if (arg == "--bench-kernels" && hasValue) {
+            options.benchKernelGames = std::stoll(argv[++i]);
+        } else if (arg == "--seed" && hasValue) {
+            options.seed = std::stoull(argv[++i]);
+            options.seeded = true;
+        } else if (arg == "--placement" && hasValue) {
+            options.placement = ThreadPlacement::parse(argv[++i]);
+        } else if (arg == "--event-log" && hasValue) {
+            options.eventLogPath = argv[++i];
+        } else if (arg == "--strategy" && hasValue) {
+            options.strategy = parseStrategy(argv[++i]);
+        } else if (arg == "--latency-json" && hasValue) {
+            options.latencyJson = argv[++i];
+        } else if (arg == "--bench-rtt" && hasValue) {
+            options.benchRoundTrips = std::stol(argv[++i]);
+        } else {
+            return false;
+        }
+    }
+#ifdef PLATFORM_WINDOWS
+    bool validBackend = options.backend == "threads";
+#else
+    bool validBackend = options.backend == "processes" || options.backend == "threads";
+#endif
+    return validBackend && (options.transport == "pipe" || options.transport == "shm") &&
+           (options.players == 0 ||
+            (options.players >= MIN_PLAYERS && options.players <= MAX_PLAYERS)) &&
+           options.benchRoundTrips >= 0 && options.deadlineMs >= 0 && options.thinkMs >= 0 &&
+           options.simulateGames >= 0 && options.threads > 0 && options.benchKernelGames >= 0 &&
+           options.benchTurnGames >= 0;
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    try {
+        if (!parseOptions(argc, argv, options)) {
+            printUsage();
+            return 1;
+        }
+    } catch (const std::exception&) {
+        printUsage();
+        return 1;
+    }
+    if (options.seeded) {
+        setMasterSeed(options.seed);
+    }
+    LatencyRecorder::instance().setEnabled(!options.latencyJson.empty());
+    if (!options.latencyJson.empty()) {
+        LatencyRecorder::instance().dumpJsonAtExit(options.latencyJson);
+    }
+
+    std::unique_ptr<EventLogWriter> eventLog;
+    if (!options.eventLogPath.empty()) {
+        try {
+            eventLog = std::make_unique<EventLogWriter>(options.eventLogPath);
+        } catch (const std::exception& e) {
+            cerr << e.what() << "\n";
+            return 1;
+        }
+        options.eventLog = eventLog.get();
+    }
+
+    if (options.benchTurnGames > 0) {
+        return runTurnBenchmark(options);
+    }
+
+    if (options.benchKernelGames > 0) {
+        return runKernelBenchmark(options);
+    }
+
+    if (options.simulateGames > 0) {
+        return runSimulationMode(options);
+    }
+
+    if (options.benchRoundTrips > 0) {
+        return runRoundTripBenchmark(options);
+    }
+
+    int playerCount = options.players;
     
     cout << "=== Seven and a Half (Cross-Platform) ===\n";
     
@@ -372,7 +983,7 @@ int main() {
     cout << "Detected: Unix/Linux\n";
     #endif
     
-    do {
+    while (playerCount < MIN_PLAYERS || playerCount > MAX_PLAYERS) {
         cout << "\nEnter number of players (" << MIN_PLAYERS << "-" 
              << MAX_PLAYERS << "): ";
         cin >> playerCount;
@@ -386,7 +997,7 @@ int main() {
         if (playerCount < MIN_PLAYERS || playerCount > MAX_PLAYERS) {
             cout << "Invalid number.\n";
         }
-    } while (playerCount < MIN_PLAYERS || playerCount > MAX_PLAYERS);
+    }
 
-    return runGame(playerCount);
+    return runGame(playerCount, options);
 }
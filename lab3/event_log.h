@@ -0,0 +1,288 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include "game_rules.h"
+
+#ifndef _WIN32
+    #include <cerrno>
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+// Append-only binary log of game events. The file is a 64-byte header
+// followed by 8-byte records, all mapped into memory: the dealer appends an
+// event with one store into the mapping plus a count update, no formatting
+// and no system call, and a reader maps the same file and walks the records
+// in place. The record count lives in the header and is updated after each
+// record, so a log cut short by a crash still ends on a whole record.
+//
+// Scores and cards are stored in half points, which every card is a multiple
+// of. Records use the byte order of the machine that wrote them.
+
+enum GameEventType : uint8_t {
+    EVENT_GAME_START = 1,  // value = number of players
+    EVENT_DEAL = 2,        // value = card dealt to player
+    EVENT_HIT = 3,         // player asked for another card; value = score
+    EVENT_STAND = 4,       // value = final score
+    EVENT_BUST = 5,        // value = final score
+    EVENT_TIMEOUT = 6,     // player missed the deadline and stands; value = score
+    EVENT_GAME_END = 7     // player = winner or NO_WINNER; value = winning score
+};
+
+constexpr uint8_t NO_WINNER = 0xFF;
+
+struct GameEvent {
+    uint32_t game;   // game number within the log, from 0
+    uint8_t type;    // GameEventType
+    uint8_t player;
+    uint16_t value;  // half points or player count, see GameEventType
+};
+
+static_assert(sizeof(GameEvent) == 8, "records are 8 bytes on disk");
+
+struct EventLogHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t recordSize;
+    uint64_t records;  // complete records following the header
+    uint64_t games;    // games started
+    uint8_t reserved[32];
+};
+
+static_assert(sizeof(EventLogHeader) == 64, "the header is 64 bytes on disk");
+
+constexpr char EVENT_LOG_MAGIC[8] = {'C', 'G', 'E', 'V', 'L', 'O', 'G', '\0'};
+constexpr uint32_t EVENT_LOG_VERSION = 1;
+
+inline uint16_t toHalfPoints(float points) {
+    return static_cast<uint16_t>(points * 2);
+}
+
+inline float fromHalfPoints(uint16_t halves) {
+    return halves / 2.0f;
+}
+
+// Throws std::runtime_error unless header starts a log this build can read
+inline void checkEventLogHeader(const EventLogHeader& header, const std::string& path) {
+    if (std::memcmp(header.magic, EVENT_LOG_MAGIC, sizeof(EVENT_LOG_MAGIC)) != 0) {
+        throw std::runtime_error(path + " is not a game event log");
+    }
+    if (header.version != EVENT_LOG_VERSION || header.recordSize != sizeof(GameEvent)) {
+        throw std::runtime_error(path + " has an unsupported log version");
+    }
+}
+
+#ifndef _WIN32
+
+// Appends events to a log file, creating it or continuing an existing one.
+// Only one thread (the dealer) may append. The file grows in steps of
+// GROWTH_RECORDS and is trimmed to its records when the writer closes.
+class EventLogWriter {
+private:
+    static constexpr size_t GROWTH_RECORDS = 1 << 20;  // 8 MB of records per step
+
+    std::string path_;
+    int fd_ = -1;
+    void* mapping_ = nullptr;
+    size_t capacity_ = 0;  // records that fit in the mapping
+    EventLogHeader* header_ = nullptr;
+    GameEvent* records_ = nullptr;
+    uint32_t game_ = 0;
+
+    static size_t fileBytes(size_t records) {
+        return sizeof(EventLogHeader) + records * sizeof(GameEvent);
+    }
+
+    void fail(const std::string& what) {
+        throw std::runtime_error(what + " " + path_ + ": " + std::strerror(errno));
+    }
+
+    // Resizes the file and maps all of it; the old mapping stays valid if
+    // either step fails
+    void map(size_t capacity) {
+        if (ftruncate(fd_, static_cast<off_t>(fileBytes(capacity))) != 0) {
+            fail("Cannot grow");
+        }
+        void* mapping =
+            mmap(nullptr, fileBytes(capacity), PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+        if (mapping == MAP_FAILED) {
+            fail("Cannot map");
+        }
+        if (mapping_ != nullptr) {
+            munmap(mapping_, fileBytes(capacity_));
+        }
+        mapping_ = mapping;
+        capacity_ = capacity;
+        header_ = static_cast<EventLogHeader*>(mapping_);
+        records_ = reinterpret_cast<GameEvent*>(header_ + 1);
+    }
+
+    void grow() {
+        map(capacity_ + GROWTH_RECORDS);
+    }
+
+public:
+    explicit EventLogWriter(const std::string& path) : path_(path) {
+        fd_ = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+        if (fd_ == -1) {
+            fail("Cannot open");
+        }
+        try {
+            struct stat info;
+            if (fstat(fd_, &info) != 0) {
+                fail("Cannot stat");
+            }
+            if (info.st_size == 0) {
+                map(GROWTH_RECORDS);
+                std::memcpy(header_->magic, EVENT_LOG_MAGIC, sizeof(EVENT_LOG_MAGIC));
+                header_->version = EVENT_LOG_VERSION;
+                header_->recordSize = sizeof(GameEvent);
+            } else {
+                EventLogHeader existing;
+                if (pread(fd_, &existing, sizeof(existing), 0) != sizeof(existing)) {
+                    throw std::runtime_error(path + " is not a game event log");
+                }
+                checkEventLogHeader(existing, path);
+                map(existing.records + GROWTH_RECORDS);
+                game_ = static_cast<uint32_t>(existing.games);
+            }
+        } catch (...) {
+            if (mapping_ != nullptr) {
+                munmap(mapping_, fileBytes(capacity_));
+            }
+            close(fd_);
+            throw;
+        }
+    }
+
+    EventLogWriter(const EventLogWriter&) = delete;
+    EventLogWriter& operator=(const EventLogWriter&) = delete;
+
+    ~EventLogWriter() {
+        size_t records = header_ != nullptr ? header_->records : 0;
+        if (mapping_ != nullptr) {
+            munmap(mapping_, fileBytes(capacity_));
+        }
+        if (fd_ != -1) {
+            if (ftruncate(fd_, static_cast<off_t>(fileBytes(records))) != 0) {
+                // The slack past the last record is ignored by readers anyway
+            }
+            close(fd_);
+        }
+    }
+
+    // Starts a new game; later events belong to it until the next call
+    void beginGame(int playerCount) {
+        game_ = static_cast<uint32_t>(header_->games++);
+        append(EVENT_GAME_START, 0, static_cast<uint16_t>(playerCount));
+    }
+
+    void append(GameEventType type, int player, uint16_t value) {
+        uint64_t index = header_->records;
+        if (index == capacity_) {
+            grow();
+        }
+        records_[index] = {game_, type, static_cast<uint8_t>(player), value};
+        header_->records = index + 1;
+    }
+
+    // Ends the current game; winner is a seat or NO_WINNER
+    void endGame(int winner, float winningScore) {
+        append(EVENT_GAME_END, winner, winner == NO_WINNER ? 0 : toHalfPoints(winningScore));
+    }
+
+    uint64_t records() const {
+        return header_->records;
+    }
+};
+
+// Read-only view of a log file: the records are used straight from the
+// mapping, without copying or decoding them
+class EventLogView {
+private:
+    void* mapping_ = nullptr;
+    size_t bytes_ = 0;
+    const EventLogHeader* header_ = nullptr;
+
+public:
+    explicit EventLogView(const std::string& path) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd == -1) {
+            throw std::runtime_error("Cannot open " + path + ": " + std::strerror(errno));
+        }
+        struct stat info;
+        if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(EventLogHeader)) {
+            close(fd);
+            throw std::runtime_error(path + " is not a game event log");
+        }
+        bytes_ = static_cast<size_t>(info.st_size);
+        mapping_ = mmap(nullptr, bytes_, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (mapping_ == MAP_FAILED) {
+            mapping_ = nullptr;
+            throw std::runtime_error("Cannot map " + path + ": " + std::strerror(errno));
+        }
+#ifdef MADV_SEQUENTIAL
+        madvise(mapping_, bytes_, MADV_SEQUENTIAL);
+#endif
+        header_ = static_cast<const EventLogHeader*>(mapping_);
+        try {
+            checkEventLogHeader(*header_, path);
+        } catch (...) {
+            munmap(mapping_, bytes_);
+            throw;
+        }
+    }
+
+    EventLogView(const EventLogView&) = delete;
+    EventLogView& operator=(const EventLogView&) = delete;
+
+    ~EventLogView() {
+        if (mapping_ != nullptr) {
+            munmap(mapping_, bytes_);
+        }
+    }
+
+    const GameEvent* begin() const {
+        return reinterpret_cast<const GameEvent*>(header_ + 1);
+    }
+
+    // Stops at the last complete record, even if the writer is still running
+    const GameEvent* end() const {
+        size_t fit = (bytes_ - sizeof(EventLogHeader)) / sizeof(GameEvent);
+        size_t records = static_cast<size_t>(header_->records);
+        return begin() + (records < fit ? records : fit);
+    }
+
+    size_t size() const {
+        return static_cast<size_t>(end() - begin());
+    }
+
+    uint64_t games() const {
+        return header_->games;
+    }
+};
+
+#else
+
+// The log relies on mmap; on Windows opening one reports that instead
+class EventLogWriter {
+public:
+    explicit EventLogWriter(const std::string&) {
+        throw std::runtime_error("The event log is only available on Unix");
+    }
+    void beginGame(int) {}
+    void append(GameEventType, int, uint16_t) {}
+    void endGame(int, float) {}
+    uint64_t records() const {
+        return 0;
+    }
+};
+
+#endif
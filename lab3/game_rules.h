@@ -0,0 +1,38 @@
+#pragma once
+
+#include <array>
+
+// Rules of "Seven and a Half" shared by the interactive game and the
+// headless simulation
+
+constexpr int MIN_PLAYERS = 2;
+constexpr int MAX_PLAYERS = 10;
+constexpr float WINNING_SCORE = 7.5f;
+
+// Cards dealt with equal probability: 1-7 at face value, the three figures
+// worth half a point
+constexpr std::array<float, 10> DECK = {1, 2, 3, 4, 5, 6, 7, 0.5f, 0.5f, 0.5f};
+
+// What a player answers after receiving a card
+constexpr int DECISION_HIT = 0;
+constexpr int DECISION_STAND = 1;
+constexpr int DECISION_BUST = 2;
+
+struct Player {
+    int id;
+    float score;
+    bool standing;
+    bool busted;
+};
+
+// Seat with the highest standing score, the lowest seat on ties; -1 when
+// every player busted
+inline int findWinner(const Player* players, int count) {
+    int winner = -1;
+    for (int i = 0; i < count; ++i) {
+        if (!players[i].busted && (winner == -1 || players[i].score > players[winner].score)) {
+            winner = i;
+        }
+    }
+    return winner;
+}
@@ -0,0 +1,609 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <unordered_map>
+#include <algorithm>
+#include "game_rules.h"
+#include "../common/latency_histogram.h"
+#include "../common/memory_usage.h"
+#include "../common/rng.h"
+
+#ifdef __linux__
+    #include <unistd.h>
+    #include <fcntl.h>
+    #include <poll.h>
+    #include <sys/epoll.h>
+    #include <sys/eventfd.h>
+    #include <sys/resource.h>
+    #include <sys/socket.h>
+    #include <sys/un.h>
+#endif
+
+using std::cerr;
+using std::cout;
+using std::fixed;
+using std::setprecision;
+using std::string;
+using std::vector;
+
+// Long-running Seven and a Half server. Player clients connect over a Unix
+// domain SOCK_SEQPACKET socket (one message per card or decision, boundaries
+// kept by the kernel). Every `seats` connections form a table, and each
+// table lives entirely on one of a few event-loop threads, so a game never
+// needs a lock. Tables deal a whole round, collect decisions as they arrive
+// and start the next game as soon as one ends. The --load mode is the
+// bundled client: it opens thousands of simulated players.
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int DEFAULT_SEATS = 4;
+constexpr int MAX_EVENTS = 256;
+
+enum MessageType : uint32_t {
+    MSG_CARD = 1,    // card dealt; status 1 = decide, 0 = busted
+    MSG_RESULT = 2   // game over; status 1 = won, 0 = lost
+};
+
+struct ServerMessage {
+    uint32_t type;
+    float card;
+    float score;
+    int32_t status;
+};
+
+struct ClientMessage {
+    int32_t decision;  // DECISION_HIT or DECISION_STAND
+};
+
+// Command line configuration
+struct Options {
+    bool serve = false;
+    bool load = false;
+    string socketPath = "/tmp/seven_and_a_half.sock";
+    int loops = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    int seats = DEFAULT_SEATS;
+    int players = 4000;
+    int durationS = 10;
+    int reportMs = 1000;
+    bool seeded = false;
+    uint64_t seed = 0;
+};
+
+void printUsage() {
+    cerr << "Usage: game_server --serve [--socket PATH] [--loops N] [--seats N]\n"
+         << "                   [--duration-s S] [--report-ms MS] [--seed S]\n"
+         << "       game_server --load [--socket PATH] [--players N] [--loops N]\n"
+         << "                   [--seats N] [--duration-s S]\n"
+         << "  --duration-s 0 keeps the server running until it is killed\n";
+}
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (arg == "--serve") {
+            options.serve = true;
+        } else if (arg == "--load") {
+            options.load = true;
+        } else if (arg == "--socket" && hasValue) {
+            options.socketPath = argv[++i];
+        } else if (arg == "--loops" && hasValue) {
+            options.loops = std::stoi(argv[++i]);
+        } else if (arg == "--seats" && hasValue) {
+            options.seats = std::stoi(argv[++i]);
+        } else if (arg == "--players" && hasValue) {
+            options.players = std::stoi(argv[++i]);
+        } else if (arg == "--duration-s" && hasValue) {
+            options.durationS = std::stoi(argv[++i]);
+        } else if (arg == "--report-ms" && hasValue) {
+            options.reportMs = std::stoi(argv[++i]);
+        } else if (arg == "--seed" && hasValue) {
+            options.seed = std::stoull(argv[++i]);
+            options.seeded = true;
+        } else {
+            return false;
+        }
+    }
+    return options.serve != options.load && options.loops > 0 &&
+           options.seats >= MIN_PLAYERS && options.seats <= MAX_PLAYERS &&
+           options.players > 0 && options.durationS >= 0 && options.reportMs > 0;
+}
+
+#ifdef __linux__
+
+// Thousands of connections need more than the default descriptor limit
+void raiseDescriptorLimit() {
+    rlimit limit{};
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+}
+
+void setNonBlocking(int fd) {
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+}
+
+sockaddr_un socketAddress(const string& path) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    path.copy(address.sun_path, sizeof(address.sun_path) - 1);
+    return address;
+}
+
+struct Table;
+
+struct Seat {
+    int fd = -1;
+    Table* table = nullptr;
+    float score = 0;
+    bool standing = false;
+    bool busted = false;
+    bool awaiting = false;
+    Clock::time_point cardSentAt;
+};
+
+struct Table {
+    Seat seats[MAX_PLAYERS];
+    int seatCount = 0;
+    int pending = 0;      // decisions still missing this round
+    bool broken = false;  // a player left; the table is closed
+    Xoshiro256 rng;
+};
+
+// One event-loop thread and the tables it owns
+class EventLoop {
+public:
+    struct Stats {
+        uint64_t games = 0;
+        uint64_t decisions = 0;
+        LatencyHistogram latency;  // card sent -> decision received, ns
+    };
+
+private:
+    int epollFd_;
+    int wakeFd_;
+    std::mutex inboxMutex_;
+    vector<vector<int>> inbox_;  // new tables handed over by the acceptor
+    std::unordered_map<Table*, std::unique_ptr<Table>> tables_;
+    vector<Table*> broken_;  // closed once the current epoll batch is handled
+    std::atomic<bool> stopping_{false};
+    std::atomic<int> connections_{0};
+    std::mutex statsMutex_;
+    Stats stats_;
+    std::thread thread_;
+
+    bool sendTo(Seat& seat, const ServerMessage& message) {
+        if (send(seat.fd, &message, sizeof(message), MSG_NOSIGNAL) != sizeof(message)) {
+            // A player that cannot take two small messages is gone
+            seat.table->broken = true;
+            return false;
+        }
+        return true;
+    }
+
+    // Deals one card to every active seat; a table with nothing left to ask
+    // has finished its game
+    void dealRound(Table& table) {
+        for (int i = 0; i < table.seatCount; ++i) {
+            Seat& seat = table.seats[i];
+            if (seat.standing || seat.busted) continue;
+
+            float card = DECK[table.rng.below(DECK.size())];
+            seat.score += card;
+            seat.busted = seat.score > WINNING_SCORE;
+            if (!seat.busted) {
+                seat.awaiting = true;
+                seat.cardSentAt = Clock::now();
+                ++table.pending;
+            }
+            sendTo(seat, {MSG_CARD, card, seat.score, seat.busted ? 0 : 1});
+        }
+        if (table.pending == 0 && !table.broken) {
+            finishGame(table);
+        }
+    }
+
+    // Announces the winner and immediately starts the next game
+    void finishGame(Table& table) {
+        int winner = -1;
+        float bestScore = -1;
+        for (int i = 0; i < table.seatCount; ++i) {
+            const Seat& seat = table.seats[i];
+            if (!seat.busted && seat.score > bestScore) {
+                bestScore = seat.score;
+                winner = i;
+            }
+        }
+        for (int i = 0; i < table.seatCount; ++i) {
+            Seat& seat = table.seats[i];
+            sendTo(seat, {MSG_RESULT, 0, seat.score, i == winner ? 1 : 0});
+            seat.score = 0;
+            seat.standing = false;
+            seat.busted = false;
+        }
+        {
+            std::lock_guard<std::mutex> lock(statsMutex_);
+            ++stats_.games;
+        }
+        if (!table.broken) {
+            dealRound(table);
+        }
+    }
+
+    void onDecision(Seat& seat, const ClientMessage& message) {
+        if (!seat.awaiting) return;
+        Table& table = *seat.table;
+        auto latency = Clock::now() - seat.cardSentAt;
+        {
+            std::lock_guard<std::mutex> lock(statsMutex_);
+            ++stats_.decisions;
+            stats_.latency.record(static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(latency).count()));
+        }
+
+        seat.awaiting = false;
+        seat.standing = message.decision == DECISION_STAND;
+        if (--table.pending == 0) {
+            dealRound(table);
+        }
+    }
+
+    void closeTable(Table* table) {
+        for (int i = 0; i < table->seatCount; ++i) {
+            close(table->seats[i].fd);  // also removes it from the epoll set
+        }
+        connections_ -= table->seatCount;
+        tables_.erase(table);
+    }
+
+    void openTables() {
+        vector<vector<int>> groups;
+        {
+            std::lock_guard<std::mutex> lock(inboxMutex_);
+            groups.swap(inbox_);
+        }
+        for (auto& fds : groups) {
+            auto table = std::make_unique<Table>();
+            table->seatCount = static_cast<int>(fds.size());
+            table->rng.seed(masterSeed(), threadRng().next());
+            for (int i = 0; i < table->seatCount; ++i) {
+                Seat& seat = table->seats[i];
+                seat.fd = fds[i];
+                seat.table = table.get();
+                setNonBlocking(seat.fd);
+                epoll_event event{};
+                event.events = EPOLLIN;
+                event.data.ptr = &seat;
+                epoll_ctl(epollFd_, EPOLL_CTL_ADD, seat.fd, &event);
+            }
+            connections_ += table->seatCount;
+            Table* raw = table.get();
+            tables_.emplace(raw, std::move(table));
+            dealRound(*raw);
+            if (raw->broken) broken_.push_back(raw);
+        }
+    }
+
+    // Closing frees the seats, and later events of a batch may still point at
+    // them, so broken tables are only closed after the whole batch
+    void closeBrokenTables() {
+        for (Table* table : broken_) {
+            closeTable(table);
+        }
+        broken_.clear();
+    }
+
+    void run() {
+        epoll_event events[MAX_EVENTS];
+        while (!stopping_.load()) {
+            int count = epoll_wait(epollFd_, events, MAX_EVENTS, -1);
+            for (int i = 0; i < count; ++i) {
+                if (events[i].data.ptr == nullptr) {
+                    uint64_t value;
+                    read(wakeFd_, &value, sizeof(value));
+                    openTables();
+                    continue;
+                }
+
+                Seat& seat = *static_cast<Seat*>(events[i].data.ptr);
+                Table* table = seat.table;
+                if (table->broken) continue;  // broke earlier in this batch, closed below
+
+                ClientMessage message;
+                if (recv(seat.fd, &message, sizeof(message), 0) == sizeof(message)) {
+                    onDecision(seat, message);
+                } else {
+                    table->broken = true;
+                }
+                if (table->broken) broken_.push_back(table);
+            }
+            closeBrokenTables();
+        }
+
+        while (!tables_.empty()) {
+            closeTable(tables_.begin()->first);
+        }
+    }
+
+public:
+    EventLoop() {
+        epollFd_ = epoll_create1(0);
+        wakeFd_ = eventfd(0, EFD_NONBLOCK);
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.ptr = nullptr;
+        epoll_ctl(epollFd_, EPOLL_CTL_ADD, wakeFd_, &event);
+        thread_ = std::thread(&EventLoop::run, this);
+    }
+
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    ~EventLoop() {
+        stopping_.store(true);
+        uint64_t one = 1;
+        write(wakeFd_, &one, sizeof(one));
+        thread_.join();
+        close(wakeFd_);
+        close(epollFd_);
+    }
+
+    // Called by the acceptor thread: the loop seats these players at a new table
+    void addTable(vector<int> fds) {
+        {
+            std::lock_guard<std::mutex> lock(inboxMutex_);
+            inbox_.push_back(std::move(fds));
+        }
+        uint64_t one = 1;
+        write(wakeFd_, &one, sizeof(one));
+    }
+
+    int connections() const {
+        return connections_.load();
+    }
+
+    // Returns the counters since the previous call
+    Stats takeStats() {
+        std::lock_guard<std::mutex> lock(statsMutex_);
+        Stats taken = stats_;
+        stats_ = Stats();
+        return taken;
+    }
+};
+
+// Memory per connection is shown twice: the growth of this process's RSS,
+// and the growth of the kernel's slab memory, where the socket structures
+// and queued messages live (system-wide, so it includes the clients' ends)
+void printServerReport(const char* label, double seconds, const EventLoop::Stats& stats,
+                       int connections, const MemoryUsage& baseline, long baselineSlabKb) {
+    MemoryUsage memory = readMemoryUsage();
+    cout << label << " " << fixed << setprecision(1) << seconds << " s: " << connections
+         << " connections, " << setprecision(0) << stats.games / seconds << " tables/s, "
+         << stats.decisions / seconds << " decisions/s, decision latency p50 "
+         << setprecision(1) << stats.latency.percentile(50) / 1000.0 << " us, p99 "
+         << stats.latency.percentile(99) / 1000.0 << " us, p99.9 "
+         << stats.latency.percentile(99.9) / 1000.0 << " us, RSS " << memory.rssKb << " KB";
+    if (connections > 0) {
+        cout << " (" << setprecision(2)
+             << static_cast<double>(memory.rssKb - baseline.rssKb) / connections
+             << " KB RSS/connection, "
+             << static_cast<double>(readKernelSlabKb() - baselineSlabKb) / connections
+             << " KB kernel slab/connection)";
+    }
+    cout << "\n";
+}
+
+int runServer(const Options& options) {
+    raiseDescriptorLimit();
+    MemoryUsage baseline = readMemoryUsage();
+    long baselineSlabKb = readKernelSlabKb();
+
+    int listener = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+    sockaddr_un address = socketAddress(options.socketPath);
+    unlink(options.socketPath.c_str());
+    if (listener == -1 || bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == -1 ||
+        listen(listener, SOMAXCONN) == -1) {
+        cerr << "Cannot listen on " << options.socketPath << "\n";
+        return 1;
+    }
+
+    vector<std::unique_ptr<EventLoop>> loops;
+    for (int i = 0; i < options.loops; ++i) {
+        loops.push_back(std::make_unique<EventLoop>());
+    }
+    cout << "Serving on " << options.socketPath << " with " << options.loops
+         << " event loops, " << options.seats << " seats per table\n";
+
+    auto start = Clock::now();
+    auto lastReport = start;
+    EventLoop::Stats total;
+    vector<int> waiting;
+    size_t nextLoop = 0;
+
+    while (options.durationS == 0 || Clock::now() - start < std::chrono::seconds(options.durationS)) {
+        pollfd listenPoll{listener, POLLIN, 0};
+        if (poll(&listenPoll, 1, 50) > 0) {
+            int fd = accept(listener, nullptr, nullptr);
+            if (fd != -1) {
+                waiting.push_back(fd);
+                if (static_cast<int>(waiting.size()) == options.seats) {
+                    loops[nextLoop]->addTable(std::move(waiting));
+                    waiting.clear();
+                    nextLoop = (nextLoop + 1) % loops.size();
+                }
+            }
+        }
+
+        auto now = Clock::now();
+        if (now - lastReport >= std::chrono::milliseconds(options.reportMs)) {
+            EventLoop::Stats interval;
+            int connections = 0;
+            for (auto& loop : loops) {
+                EventLoop::Stats stats = loop->takeStats();
+                interval.games += stats.games;
+                interval.decisions += stats.decisions;
+                interval.latency.merge(stats.latency);
+                connections += loop->connections();
+            }
+            total.games += interval.games;
+            total.decisions += interval.decisions;
+            total.latency.merge(interval.latency);
+            printServerReport("Last", std::chrono::duration<double>(now - lastReport).count(),
+                              interval, connections, baseline, baselineSlabKb);
+            lastReport = now;
+        }
+    }
+
+    for (auto& loop : loops) {
+        EventLoop::Stats stats = loop->takeStats();
+        total.games += stats.games;
+        total.decisions += stats.decisions;
+        total.latency.merge(stats.latency);
+    }
+    printServerReport("Total", std::chrono::duration<double>(Clock::now() - start).count(), total,
+                      0, baseline, baselineSlabKb);
+
+    loops.clear();
+    for (int fd : waiting) close(fd);
+    close(listener);
+    unlink(options.socketPath.c_str());
+    return 0;
+}
+
+// Load generator: simulated players spread over a few epoll threads, each
+// answering every card with a coin flip
+struct LoadStats {
+    uint64_t results = 0;
+    uint64_t wins = 0;
+    uint64_t cards = 0;
+};
+
+void runLoadThread(vector<int> fds, Clock::time_point deadline, LoadStats& stats) {
+    int epollFd = epoll_create1(0);
+    for (int fd : fds) {
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+    }
+
+    Xoshiro256& rng = threadRng();
+    LoadStats local;
+    epoll_event events[MAX_EVENTS];
+    while (Clock::now() < deadline) {
+        int count = epoll_wait(epollFd, events, MAX_EVENTS, 10);
+        for (int i = 0; i < count; ++i) {
+            ServerMessage message;
+            if (recv(events[i].data.fd, &message, sizeof(message), 0) != sizeof(message)) {
+                epoll_ctl(epollFd, EPOLL_CTL_DEL, events[i].data.fd, nullptr);
+                continue;
+            }
+            if (message.type == MSG_CARD) {
+                ++local.cards;
+                if (message.status == 1) {
+                    ClientMessage reply{static_cast<int32_t>(rng.below(2))};
+                    send(events[i].data.fd, &reply, sizeof(reply), MSG_NOSIGNAL);
+                }
+            } else if (message.type == MSG_RESULT) {
+                ++local.results;
+                local.wins += message.status;
+            }
+        }
+    }
+
+    close(epollFd);
+    stats = local;
+}
+
+int runLoad(const Options& options) {
+    raiseDescriptorLimit();
+    MemoryUsage baseline = readMemoryUsage();
+    long baselineSlabKb = readKernelSlabKb();
+    sockaddr_un address = socketAddress(options.socketPath);
+
+    // Whole tables only: a partial table would wait forever for its last seat
+    int players = options.players / options.seats * options.seats;
+    vector<vector<int>> fdsPerThread(options.loops);
+    for (int i = 0; i < players; ++i) {
+        int fd = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+        if (fd == -1 || connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == -1) {
+            cerr << "Cannot connect player " << i << " to " << options.socketPath << "\n";
+            return 1;
+        }
+        // Seats of one table go to one thread, in the order the server seats them
+        fdsPerThread[(i / options.seats) % options.loops].push_back(fd);
+    }
+    MemoryUsage connected = readMemoryUsage();
+    long connectedSlabKb = readKernelSlabKb();
+
+    auto start = Clock::now();
+    auto deadline = start + std::chrono::seconds(std::max(1, options.durationS));
+    vector<LoadStats> stats(options.loops);
+    vector<std::thread> threads;
+    for (int i = 0; i < options.loops; ++i) {
+        threads.emplace_back(runLoadThread, std::move(fdsPerThread[i]), deadline, std::ref(stats[i]));
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    LoadStats total;
+    for (const auto& threadStats : stats) {
+        total.results += threadStats.results;
+        total.wins += threadStats.wins;
+        total.cards += threadStats.cards;
+    }
+    uint64_t games = total.results / options.seats;
+    cout << "Players: " << players << " at " << players / options.seats << " tables, "
+         << options.loops << " client threads\n"
+         << "Games: " << games << " in " << fixed << setprecision(1) << seconds << " s ("
+         << setprecision(0) << games / seconds << " tables/s, " << total.cards / seconds
+         << " cards/s)\n"
+         << "Client memory: " << setprecision(2)
+         << static_cast<double>(connected.rssKb - baseline.rssKb) / players
+         << " KB RSS/connection, "
+         << static_cast<double>(connectedSlabKb - baselineSlabKb) / players
+         << " KB kernel slab/connection (system-wide, both socket ends)\n";
+    return 0;
+}
+
+#else
+
+int runServer(const Options&) {
+    cerr << "The game server needs Linux (epoll, SOCK_SEQPACKET)\n";
+    return 1;
+}
+
+int runLoad(const Options&) {
+    cerr << "The load generator needs Linux (epoll, SOCK_SEQPACKET)\n";
+    return 1;
+}
+
+#endif
+
+int main(int argc, char* argv[]) {
+    Options options;
+    try {
+        if (!parseOptions(argc, argv, options)) {
+            printUsage();
+            return 1;
+        }
+    } catch (const std::exception&) {
+        printUsage();
+        return 1;
+    }
+
+    if (options.seeded) {
+        setMasterSeed(options.seed);
+    }
+    return options.serve ? runServer(options) : runLoad(options);
+}
@@ -0,0 +1,240 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <chrono>
+#include <cstdint>
+#include "game_rules.h"
+#include "event_log.h"
+
+using std::cerr;
+using std::cout;
+using std::fixed;
+using std::setprecision;
+using std::setw;
+using std::string;
+
+// Rebuilds results and statistics from a card_game --event-log file. The log
+// is mapped and its records are read where they lie, so a replay is one pass
+// of plain loads and a switch per event. Every game's winner is worked out
+// again from its deals and decisions and checked against the recorded one.
+// The replay applies the limit itself: a seat whose cards add up to more
+// than WINNING_SCORE is busted, whatever the log says it did afterwards.
+
+#ifdef _WIN32
+
+int main() {
+    cerr << "replay_log is only available on Unix (mmap)\n";
+    return 1;
+}
+
+#else
+
+struct Options {
+    string path;
+    int showGames = 0;  // print the outcome of the first N games
+    int repeat = 1;     // replay this many times, to time small logs
+};
+
+struct SeatTotals {
+    uint64_t wins = 0;
+    uint64_t stands = 0;
+    uint64_t busts = 0;
+    uint64_t timeouts = 0;
+};
+
+struct ReplayStats {
+    uint64_t events = 0;
+    uint64_t games = 0;     // games that ended in the log
+    uint64_t cards = 0;
+    uint64_t noWinner = 0;
+    uint64_t winningHalves = 0;  // sum of winning scores, in half points
+    uint64_t mismatches = 0;     // replayed winner differs, or a malformed event
+                                 // such as a stand over the limit
+    SeatTotals seats[MAX_PLAYERS];
+};
+
+enum SeatState : uint8_t { SEAT_ACTIVE, SEAT_STANDING, SEAT_BUSTED };
+
+const uint16_t LIMIT_HALVES = toHalfPoints(WINNING_SCORE);
+
+// State of the game being replayed
+struct ReplayGame {
+    int players = 0;
+    uint16_t scores[MAX_PLAYERS] = {};
+    uint8_t states[MAX_PLAYERS] = {};
+
+    int winner() const {
+        int best = NO_WINNER;
+        for (int i = 0; i < players; ++i) {
+            if (states[i] != SEAT_BUSTED && (best == NO_WINNER || scores[i] > scores[best])) {
+                best = i;
+            }
+        }
+        return best;
+    }
+};
+
+void printGame(uint32_t game, const ReplayGame& state, int winner) {
+    cout << "Game " << game << ":";
+    for (int i = 0; i < state.players; ++i) {
+        cout << " " << fixed << setprecision(1) << fromHalfPoints(state.scores[i])
+             << (state.states[i] == SEAT_BUSTED ? " (bust)" : "");
+    }
+    if (winner == NO_WINNER) {
+        cout << " -> no winner\n";
+    } else {
+        cout << " -> player " << winner << " wins\n";
+    }
+}
+
+// One pass over the records
+void replay(const GameEvent* first, const GameEvent* last, int showGames, ReplayStats& stats) {
+    ReplayGame game;
+    for (const GameEvent* event = first; event != last; ++event) {
+        int player = event->player;
+        if (event->type != EVENT_GAME_START && event->type != EVENT_GAME_END &&
+            player >= game.players) {
+            ++stats.mismatches;
+            continue;
+        }
+        switch (event->type) {
+            case EVENT_GAME_START:
+                game = ReplayGame();
+                game.players = event->value <= MAX_PLAYERS ? event->value : 0;
+                break;
+            case EVENT_DEAL:
+                game.scores[player] = static_cast<uint16_t>(game.scores[player] + event->value);
+                if (game.scores[player] > LIMIT_HALVES) {
+                    game.states[player] = SEAT_BUSTED;
+                }
+                ++stats.cards;
+                break;
+            case EVENT_HIT:
+                break;
+            case EVENT_STAND:
+            case EVENT_TIMEOUT:
+                if (event->type == EVENT_TIMEOUT) {
+                    ++stats.seats[player].timeouts;
+                }
+                if (game.states[player] == SEAT_BUSTED) {
+                    ++stats.mismatches;  // recorded as standing over the limit
+                    ++stats.seats[player].busts;
+                } else {
+                    game.states[player] = SEAT_STANDING;
+                    ++stats.seats[player].stands;
+                }
+                break;
+            case EVENT_BUST:
+                game.states[player] = SEAT_BUSTED;
+                ++stats.seats[player].busts;
+                break;
+            case EVENT_GAME_END: {
+                int winner = game.winner();
+                if (winner != player) {
+                    ++stats.mismatches;
+                }
+                if (winner == NO_WINNER) {
+                    ++stats.noWinner;
+                } else {
+                    ++stats.seats[winner].wins;
+                    stats.winningHalves += game.scores[winner];
+                }
+                if (stats.games < static_cast<uint64_t>(showGames)) {
+                    printGame(event->game, game, winner);
+                }
+                ++stats.games;
+                break;
+            }
+            default:
+                ++stats.mismatches;
+                break;
+        }
+    }
+    stats.events += static_cast<uint64_t>(last - first);
+}
+
+void printStats(const ReplayStats& stats, double seconds, int repeat) {
+    auto percent = [&](uint64_t count) {
+        return stats.games == 0 ? 0.0 : 100.0 * static_cast<double>(count) / stats.games;
+    };
+
+    cout << "Events: " << stats.events / repeat << ", games: " << stats.games / repeat
+         << ", cards dealt: " << stats.cards / repeat << "\n"
+         << "Replayed " << stats.events << " events in " << fixed << setprecision(3) << seconds
+         << " s (" << setprecision(1) << stats.events / seconds / 1e6 << " M events/s)\n\n"
+         << "Seat | Win %  | Bust % | Stand % | Timeouts\n"
+         << "--------------------------------------------\n"
+         << setprecision(2);
+    for (int i = 0; i < MAX_PLAYERS; ++i) {
+        const SeatTotals& seat = stats.seats[i];
+        if (seat.stands + seat.busts == 0) {
+            continue;
+        }
+        cout << setw(4) << i << " | " << setw(6) << percent(seat.wins) << " | " << setw(6)
+             << percent(seat.busts) << " | " << setw(7) << percent(seat.stands) << " | "
+             << setw(8) << seat.timeouts / repeat << "\n";
+    }
+
+    uint64_t won = stats.games - stats.noWinner;
+    cout << "\nNo winner: " << percent(stats.noWinner) << " %\n"
+         << "Mean cards per game: " << (stats.games == 0 ? 0.0 : double(stats.cards) / stats.games)
+         << "\n"
+         << "Mean winning score: " << (won == 0 ? 0.0 : stats.winningHalves / 2.0 / won) << "\n"
+         << "Winner mismatches: " << stats.mismatches / repeat << "\n";
+}
+
+void printUsage() {
+    cerr << "Usage: replay_log LOG [--show GAMES] [--repeat N]\n";
+}
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (arg == "--show" && hasValue) {
+            options.showGames = std::stoi(argv[++i]);
+        } else if (arg == "--repeat" && hasValue) {
+            options.repeat = std::stoi(argv[++i]);
+        } else if (options.path.empty() && arg.compare(0, 2, "--") != 0) {
+            options.path = arg;
+        } else {
+            return false;
+        }
+    }
+    return !options.path.empty() && options.showGames >= 0 && options.repeat > 0;
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    try {
+        if (!parseOptions(argc, argv, options)) {
+            printUsage();
+            return 1;
+        }
+    } catch (const std::exception&) {
+        printUsage();
+        return 1;
+    }
+
+    try {
+        EventLogView log(options.path);
+        ReplayStats stats;
+        auto start = std::chrono::steady_clock::now();
+        for (int pass = 0; pass < options.repeat; ++pass) {
+            replay(log.begin(), log.end(), pass == 0 ? options.showGames : 0, stats);
+        }
+        double seconds =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (options.showGames > 0) {
+            cout << "\n";
+        }
+        printStats(stats, seconds, options.repeat);
+    } catch (const std::exception& e) {
+        cerr << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
+
+#endif
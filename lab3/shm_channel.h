@@ -0,0 +1,184 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include "../common/futex.h"
+#include "../common/affinity.h"
+
+// Dealer <-> player transport over shared memory. Every player gets two
+// single-producer/single-consumer rings (cards in, decisions out) inside one
+// MAP_SHARED region created before fork(). A message is a store into the ring
+// plus a release of the tail index; the receiver spins for a while and only
+// then sleeps on a process-shared futex, so a busy table exchanges cards
+// without a single syscall.
+
+// Bounded SPSC ring of trivially copyable values. Head and tail live on their
+// own cache lines, and each side caches the other side's index so it only
+// touches the shared line when its cached copy says the ring is full/empty.
+template <typename T, size_t Capacity>
+class SpscRing {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+                  "capacity must be a power of two");
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "elements are copied between processes");
+
+private:
+    static constexpr size_t CACHE_LINE_SIZE = 64;
+    static constexpr size_t MASK = Capacity - 1;
+
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> head_{0};  // next slot to read
+    size_t cachedTail_ = 0;                                  // consumer only
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> tail_{0};  // next slot to write
+    size_t cachedHead_ = 0;                                  // producer only
+    alignas(CACHE_LINE_SIZE) T slots_[Capacity];
+
+public:
+    SpscRing() = default;
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    bool tryPush(const T& value) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - cachedHead_ == Capacity) {
+            cachedHead_ = head_.load(std::memory_order_acquire);
+            if (tail - cachedHead_ == Capacity) {
+                return false;
+            }
+        }
+        slots_[tail & MASK] = value;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool tryPop(T& value) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head == cachedTail_) {
+            cachedTail_ = tail_.load(std::memory_order_acquire);
+            if (head == cachedTail_) {
+                return false;
+            }
+        }
+        value = slots_[head & MASK];
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+};
+
+// One direction of a link: a ring plus the futex word its consumer sleeps on
+template <typename T>
+class ShmQueue {
+public:
+    static constexpr size_t CAPACITY = 64;
+    static constexpr int SPIN_LIMIT = 4000;
+
+private:
+    SpscRing<T, CAPACITY> ring_;
+    alignas(64) std::atomic<uint32_t> signal_{0};
+    std::atomic<uint32_t> waiting_{0};
+
+public:
+    void push(const T& value) {
+        while (!ring_.tryPush(value)) {
+            std::this_thread::yield();
+        }
+        signal_.fetch_add(1);
+        if (waiting_.load() != 0) {
+            futexWake(&signal_, 1, true);
+        }
+    }
+
+    // Spins SPIN_LIMIT times, then sleeps until the producer signals. On a
+    // single CPU the producer cannot run while we spin, so we sleep at once.
+    T pop() {
+        static const int spinLimit = std::thread::hardware_concurrency() > 1 ? SPIN_LIMIT : 0;
+        T value;
+        int spins = 0;
+        while (!ring_.tryPop(value)) {
+            if (++spins < spinLimit) {
+                continue;
+            }
+
+            // Read the signal before announcing the wait: a push that lands
+            // after this point changes the word and the wait returns at once
+            uint32_t signal = signal_.load();
+            waiting_.store(1);
+            if (ring_.tryPop(value)) {
+                waiting_.store(0);
+                break;
+            }
+            futexWait(&signal_, signal, true);
+            waiting_.store(0);
+            spins = 0;
+        }
+        return value;
+    }
+
+    bool tryPop(T& value) {
+        return ring_.tryPop(value);
+    }
+
+    // Like pop(), but gives up and returns false once the deadline passes
+    bool popUntil(T& value, std::chrono::steady_clock::time_point deadline) {
+        while (!ring_.tryPop(value)) {
+            auto remaining = deadline - std::chrono::steady_clock::now();
+            if (remaining <= std::chrono::steady_clock::duration::zero()) {
+                return false;
+            }
+            uint32_t signal = signal_.load();
+            waiting_.store(1);
+            if (ring_.tryPop(value)) {
+                waiting_.store(0);
+                break;
+            }
+            futexWait(&signal_, signal, true,
+                      std::chrono::duration_cast<std::chrono::nanoseconds>(remaining).count());
+            waiting_.store(0);
+        }
+        return true;
+    }
+};
+
+struct ShmLink {
+    ShmQueue<float> cards;        // dealer -> player
+    ShmQueue<int32_t> decisions;  // player -> dealer
+};
+
+// Owns the MAP_SHARED region holding one ShmLink per player. Create it before
+// forking; parent and children then use the same links. node >= 0 asks for
+// the pages on that NUMA node, where the pinned dealer and players run.
+class ShmChannel {
+private:
+    ShmLink* links_ = nullptr;
+    size_t count_ = 0;
+
+public:
+    explicit ShmChannel(size_t count, int node = -1) : count_(count) {
+        void* memory;
+        try {
+            memory = allocateOnNode(sizeof(ShmLink) * count, node, true);
+        } catch (const std::bad_alloc&) {
+            throw std::runtime_error("cannot map shared channel");
+        }
+        links_ = static_cast<ShmLink*>(memory);
+        for (size_t i = 0; i < count; ++i) {
+            new (&links_[i]) ShmLink();
+        }
+    }
+
+    ShmChannel(const ShmChannel&) = delete;
+    ShmChannel& operator=(const ShmChannel&) = delete;
+
+    ~ShmChannel() {
+        releaseNodeMemory(links_, sizeof(ShmLink) * count_);
+    }
+
+    ShmLink& link(size_t index) {
+        return links_[index];
+    }
+};
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <vector>
+#include "game_rules.h"
+#include "strategy.h"
+#include "../common/rng.h"
+
+// Headless Monte Carlo engine: plays millions of games with the same rules
+// and the same coin-flip players as card_game --strategy coin, without
+// processes, IPC or output. Games are cut into fixed-size chunks and chunk k
+// always draws from an RNG seeded with (seed, k), so the totals for a given
+// seed do not depend on the thread count or on which worker happened to run
+// which chunk.
+
+constexpr uint64_t SIMULATION_CHUNK_GAMES = 1 << 16;
+
+struct SeatStats {
+    uint64_t wins = 0;
+    uint64_t busts = 0;
+    uint64_t stands = 0;
+};
+
+struct SimulationResult {
+    uint64_t games = 0;
+    uint64_t noWinner = 0;
+    std::array<SeatStats, MAX_PLAYERS> seats{};
+
+    void merge(const SimulationResult& other) {
+        games += other.games;
+        noWinner += other.noWinner;
+        for (int i = 0; i < MAX_PLAYERS; ++i) {
+            seats[i].wins += other.seats[i].wins;
+            seats[i].busts += other.seats[i].busts;
+            seats[i].stands += other.seats[i].stands;
+        }
+    }
+};
+
+// Plays one game on the same Player structs and rules as card_game: every
+// round each active player takes a card and decide() busts it above
+// WINNING_SCORE, stands it on WINNING_SCORE or flips a coin. findWinner picks
+// the highest standing score, the lowest seat on ties.
+inline void simulateGame(Xoshiro256& rng, int playerCount, SimulationResult& result) {
+    Player players[MAX_PLAYERS];
+    for (int i = 0; i < playerCount; ++i) {
+        players[i] = {i, 0, false, false};
+    }
+    int activeCount = playerCount;
+
+    while (activeCount > 0) {
+        for (int i = 0; i < playerCount; ++i) {
+            Player& player = players[i];
+            if (player.standing || player.busted) {
+                continue;
+            }
+            player.score += DECK[rng.below(DECK.size())];
+            int decision = decide(Strategy::Coin, playerCount, i, player.score, rng);
+            if (decision == DECISION_BUST) {
+                player.busted = true;
+                --activeCount;
+            } else if (decision == DECISION_STAND) {
+                player.standing = true;
+                --activeCount;
+            }
+        }
+    }
+
+    for (int i = 0; i < playerCount; ++i) {
+        if (players[i].busted) {
+            ++result.seats[i].busts;
+        } else {
+            ++result.seats[i].stands;
+        }
+    }
+    int winner = findWinner(players, playerCount);
+    if (winner >= 0) {
+        ++result.seats[winner].wins;
+    } else {
+        ++result.noWinner;
+    }
+    ++result.games;
+}
+
+// Plays games games of playerCount players on threads workers. Each worker
+// claims chunks from a shared counter and sums into its own result; the
+// partial results are reduced once the workers have joined.
+inline SimulationResult runSimulation(uint64_t games, int playerCount, int threads,
+                                      uint64_t seed) {
+    uint64_t chunkCount = (games + SIMULATION_CHUNK_GAMES - 1) / SIMULATION_CHUNK_GAMES;
+    std::atomic<uint64_t> nextChunk{0};
+    std::vector<SimulationResult> partials(std::max(1, threads));
+
+    auto worker = [&](SimulationResult& partial) {
+        SimulationResult local;  // kept off the shared vector to avoid false sharing
+        for (uint64_t chunk = nextChunk++; chunk < chunkCount; chunk = nextChunk++) {
+            Xoshiro256 rng(seed, chunk);
+            uint64_t first = chunk * SIMULATION_CHUNK_GAMES;
+            uint64_t count = std::min(SIMULATION_CHUNK_GAMES, games - first);
+            for (uint64_t g = 0; g < count; ++g) {
+                simulateGame(rng, playerCount, local);
+            }
+        }
+        partial = local;
+    };
+
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < partials.size(); ++i) {
+        workers.emplace_back(worker, std::ref(partials[i]));
+    }
+    worker(partials[0]);
+    for (auto& thread : workers) {
+        thread.join();
+    }
+
+    SimulationResult total;
+    for (const auto& partial : partials) {
+        total.merge(partial);
+    }
+    return total;
+}
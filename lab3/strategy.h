@@ -0,0 +1,241 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include "game_rules.h"
+#include "../common/rng.h"
+
+// How players decide between another card and standing. Coin is the
+// original fair coin flip. Optimal reads a table solved at compile time:
+//
+// Every player draws from the same deck (with replacement) and only final
+// scores decide the winner, so the seats play independent one-player
+// problems coupled only through the other seats' final-score distributions.
+// Ties go to the lowest seat (findWinner), so the seats are not symmetric:
+// standing on s wins for seat k when every lower seat ends below s or busts
+// and every higher seat ends at or below s or busts. Hitting is worth the
+// expectimax over the next card, and the table keeps the better of the two
+// for every player count, seat and score. The opponents are assumed to play
+// the table themselves, so it is found by fictitious play: each round every
+// seat answers the average of the distributions of the other seats' earlier
+// answers, starting from "always stand" (plain best response keeps
+// oscillating). Scores are counted in half points, which every card is a
+// multiple of, and entries above WINNING_SCORE read DECISION_BUST, so a
+// decision is one lookup with no comparison against the limit.
+
+enum class Strategy { Coin, Optimal };
+
+inline Strategy parseStrategy(const std::string& name) {
+    if (name == "coin") {
+        return Strategy::Coin;
+    }
+    if (name == "optimal") {
+        return Strategy::Optimal;
+    }
+    throw std::invalid_argument("unknown strategy: " + name);
+}
+
+inline const char* strategyName(Strategy strategy) {
+    return strategy == Strategy::Coin ? "coin" : "optimal";
+}
+
+namespace strategy_detail {
+
+constexpr int halves(float points) {
+    return static_cast<int>(points * 2);
+}
+
+constexpr int LIMIT = halves(WINNING_SCORE);
+
+constexpr int maxCard() {
+    int largest = 0;
+    for (float card : DECK) {
+        largest = halves(card) > largest ? halves(card) : largest;
+    }
+    return largest;
+}
+
+// Scores a player can hold: up to the limit itself plus the best card, as a
+// player who hits on exactly WINNING_SCORE (a coin flip can) may draw it
+constexpr int SCORE_STEPS = LIMIT + 1 + maxCard();
+
+constexpr int FICTITIOUS_PLAY_ROUNDS = 32;
+
+// Per-score values and decisions. Plain arrays, because every std::array
+// operator[] is a function call to the constexpr evaluator
+struct Probabilities {
+    double at[LIMIT + 1];  // indexed by score in half points
+};
+
+struct Policy {
+    bool stand[LIMIT + 1];
+};
+
+constexpr double CARD_PROBABILITY = 1.0 / DECK.size();
+
+struct CardHalves {
+    int at[DECK.size()];
+};
+
+constexpr CardHalves cardHalves() {
+    CardHalves cards{};
+    for (size_t i = 0; i < DECK.size(); ++i) {
+        cards.at[i] = halves(DECK[i]);
+    }
+    return cards;
+}
+
+// The deck in half points, so the solver does no float conversions
+constexpr CardHalves CARD_HALVES = cardHalves();
+constexpr int CARD_COUNT = static_cast<int>(DECK.size());
+
+// Final-score distribution of a player following policy; bust gets the rest
+constexpr Probabilities finalScores(const Policy& policy, double& bust) {
+    Probabilities reach{};
+    Probabilities final{};
+    reach.at[0] = 1;
+    bust = 0;
+    for (int score = 0; score <= LIMIT; ++score) {
+        if (score > 0 && policy.stand[score]) {
+            final.at[score] += reach.at[score];
+            continue;
+        }
+        double share = reach.at[score] * CARD_PROBABILITY;
+        for (int card = 0; card < CARD_COUNT; ++card) {
+            int next = score + CARD_HALVES.at[card];
+            if (next > LIMIT) {
+                bust += share;
+            } else {
+                reach.at[next] += share;
+            }
+        }
+    }
+    return final;
+}
+
+// Average final-score distribution of every seat so far, bust being the rest
+struct SeatDistributions {
+    Probabilities final[MAX_PLAYERS];
+    double bust[MAX_PLAYERS];
+};
+
+struct SeatChances {
+    Probabilities seat[MAX_PLAYERS];
+};
+
+// Chance that each seat wins by standing on each score, given the other
+// seats' distributions: a lower seat beats it on a tie, a higher seat does
+// not. Prefix and suffix products over the seats give every seat at once.
+constexpr SeatChances standWinChances(const SeatDistributions& seats, int players) {
+    SeatChances wins{};
+    double below[MAX_PLAYERS] = {};  // ends under the current score or busts
+    for (int seat = 0; seat < players; ++seat) {
+        below[seat] = seats.bust[seat];
+    }
+    for (int score = 1; score <= LIMIT; ++score) {
+        double higher[MAX_PLAYERS + 1] = {};  // product over the seats from index on
+        higher[players] = 1;
+        for (int seat = players - 1; seat >= 0; --seat) {
+            higher[seat] = higher[seat + 1] * (below[seat] + seats.final[seat].at[score]);
+        }
+        double lower = 1;  // product over the seats before this one
+        for (int seat = 0; seat < players; ++seat) {
+            wins.seat[seat].at[score] = lower * higher[seat + 1];
+            lower *= below[seat];
+            below[seat] += seats.final[seat].at[score];
+        }
+    }
+    return wins;
+}
+
+// Best response to the given chances of winning by standing on each score
+constexpr Policy bestResponse(const Probabilities& standWins) {
+    Probabilities value{};
+    Policy response{};
+    for (int score = LIMIT; score >= 0; --score) {
+        double hitValue = 0;
+        for (int card = 0; card < CARD_COUNT; ++card) {
+            int next = score + CARD_HALVES.at[card];
+            hitValue += next > LIMIT ? 0 : CARD_PROBABILITY * value.at[next];
+        }
+        response.stand[score] = score > 0 && standWins.at[score] >= hitValue;
+        value.at[score] = response.stand[score] ? standWins.at[score] : hitValue;
+    }
+    return response;
+}
+
+using Table = std::array<std::array<std::array<uint8_t, SCORE_STEPS>, MAX_PLAYERS>,
+                         MAX_PLAYERS + 1>;
+
+constexpr Table solve() {
+    Table table{};
+    for (int players = MIN_PLAYERS; players <= MAX_PLAYERS; ++players) {
+        Policy policies[MAX_PLAYERS] = {};
+        Policy alwaysStand{};
+        for (bool& stand : alwaysStand.stand) {
+            stand = true;
+        }
+        SeatDistributions average{};
+        for (int seat = 0; seat < players; ++seat) {
+            average.final[seat] = finalScores(alwaysStand, average.bust[seat]);
+        }
+        for (int round = 1; round <= FICTITIOUS_PLAY_ROUNDS; ++round) {
+            SeatChances standWins = standWinChances(average, players);
+            for (int seat = 0; seat < players; ++seat) {
+                policies[seat] = bestResponse(standWins.seat[seat]);
+            }
+            for (int seat = 0; seat < players; ++seat) {
+                double bust = 0;
+                Probabilities final = finalScores(policies[seat], bust);
+                Probabilities& mean = average.final[seat];
+                for (int score = 0; score <= LIMIT; ++score) {
+                    mean.at[score] += (final.at[score] - mean.at[score]) / (round + 1);
+                }
+                average.bust[seat] += (bust - average.bust[seat]) / (round + 1);
+            }
+        }
+        for (int seat = 0; seat < MAX_PLAYERS; ++seat) {
+            for (int score = 0; score < SCORE_STEPS; ++score) {
+                table[players][seat][score] = score > LIMIT ? DECISION_BUST
+                                              : policies[seat].stand[score] ? DECISION_STAND
+                                                                            : DECISION_HIT;
+            }
+        }
+    }
+    return table;
+}
+
+}  // namespace strategy_detail
+
+// OPTIMAL_STRATEGY[players][seat][half points] is DECISION_HIT, _STAND or _BUST
+constexpr strategy_detail::Table OPTIMAL_STRATEGY = strategy_detail::solve();
+
+static_assert(OPTIMAL_STRATEGY[MIN_PLAYERS][0][strategy_detail::LIMIT] == DECISION_STAND,
+              "a player on the winning score must stand");
+static_assert(OPTIMAL_STRATEGY[MIN_PLAYERS][1][strategy_detail::halves(0.5f)] == DECISION_HIT,
+              "a player holding a single figure loses nothing by hitting");
+static_assert(OPTIMAL_STRATEGY[MAX_PLAYERS][0][strategy_detail::LIMIT + 1] == DECISION_BUST,
+              "scores over the limit are busts");
+static_assert(strategy_detail::LIMIT + strategy_detail::maxCard() <
+                  static_cast<int>(OPTIMAL_STRATEGY[MAX_PLAYERS][0].size()),
+              "every reachable score, including a hit on the limit, has an entry");
+static_assert(OPTIMAL_STRATEGY[MAX_PLAYERS][MAX_PLAYERS - 1]
+                              [strategy_detail::LIMIT + strategy_detail::maxCard()] ==
+                  DECISION_BUST,
+              "the highest reachable score is a bust");
+
+// Decision of the player in seat holding score in a game of playerCount
+// players: DECISION_BUST whenever score is over WINNING_SCORE. Coin players
+// flip for every other score except WINNING_SCORE itself, where no card can
+// help and every backend has them stand.
+inline int decide(Strategy strategy, int playerCount, int seat, float score, Xoshiro256& rng) {
+    int points = strategy_detail::halves(score);
+    int decision = OPTIMAL_STRATEGY[playerCount][seat][points];
+    if (strategy == Strategy::Coin && decision != DECISION_BUST &&
+        points != strategy_detail::LIMIT) {
+        decision = static_cast<int>(rng.below(2));  // DECISION_HIT or DECISION_STAND
+    }
+    return decision;
+}
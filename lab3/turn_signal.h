@@ -0,0 +1,80 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+#ifdef __linux__
+    #include "../common/futex.h"
+#else
+    #include <condition_variable>
+    #include <mutex>
+#endif
+
+// Binary semaphore that hands a turn to exactly one waiting thread. Each
+// player owns one, so the dealer wakes the player whose turn it is instead of
+// broadcasting to the whole table. On Linux it is a futex word that only
+// enters the kernel when the waiter is actually asleep; elsewhere it falls
+// back to a mutex and condition variable per signal.
+class TurnSignal {
+public:
+    static constexpr int SPIN_LIMIT = 2000;
+
+#ifdef __linux__
+private:
+    static constexpr uint32_t EMPTY = 0;
+    static constexpr uint32_t POSTED = 1;
+    static constexpr uint32_t SLEEPING = 2;  // empty, and the waiter is in futexWait
+
+    std::atomic<uint32_t> state_{EMPTY};
+
+    bool tryTake() {
+        uint32_t expected = POSTED;
+        return state_.compare_exchange_strong(expected, EMPTY, std::memory_order_acquire);
+    }
+
+public:
+    void post() {
+        if (state_.exchange(POSTED, std::memory_order_release) == SLEEPING) {
+            futexWake(&state_, 1, false);
+        }
+    }
+
+    // Spins briefly (on multi-core machines only), then sleeps until posted
+    void wait() {
+        static const int spinLimit = std::thread::hardware_concurrency() > 1 ? SPIN_LIMIT : 0;
+        for (int spins = 0; spins < spinLimit; ++spins) {
+            if (tryTake()) {
+                return;
+            }
+        }
+
+        while (!tryTake()) {
+            uint32_t expected = EMPTY;
+            if (state_.compare_exchange_strong(expected, SLEEPING) || expected == SLEEPING) {
+                futexWait(&state_, SLEEPING, false);
+            }
+        }
+    }
+#else
+private:
+    std::mutex mutex_;
+    std::condition_variable posted_;
+    bool ready_ = false;
+
+public:
+    void post() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ready_ = true;
+        }
+        posted_.notify_one();
+    }
+
+    void wait() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        posted_.wait(lock, [this]() { return ready_; });
+        ready_ = false;
+    }
+#endif
+};